@@ -14,39 +14,276 @@
 #define ARRAY_ARITHMETIC_H
 
 #include <string>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
 
 namespace array_arithmetic {
 	/**
-	 * length of larger array where we revert to school multiplication
+	 * Numbers are arrays of machine word digits (limbs) with the most significant
+	 * limb at index 0. Intermediate results (products and carries) are computed
+	 * using double_limb, so that the product of 2 limbs plus 2 carries cannot overflow
 	 */
-	const unsigned int RADIX = 256;
-	const unsigned int RADIX_MINUS_ONE = RADIX - 1;
-	const std::size_t KARATSUBA_THRESHOLD = 4;
+	typedef std::uint32_t limb;
+	typedef std::uint64_t double_limb;
+	const std::size_t LIMB_BITS = 32;
+	const double_limb RADIX = static_cast<double_limb>(1) << LIMB_BITS;
+	const limb RADIX_MINUS_ONE = static_cast<limb>(RADIX - 1);
+	/**
+	 * default length of smaller array where we revert to school multiplication
+	 */
+	const std::size_t KARATSUBA_THRESHOLD = 32;
+	/**
+	 * threshold actually used by karatsuba_multiply. Initialized to KARATSUBA_THRESHOLD
+	 * and can be changed at runtime for tuning
+	 */
+	extern std::size_t karatsuba_threshold;
+	/**
+	 * default lengths of the smaller array from which multiply() uses Toom-3
+	 * and Toom-4 multiplication
+	 */
+	const std::size_t TOOM3_THRESHOLD = 250;
+	const std::size_t TOOM4_THRESHOLD = 600;
+	/**
+	 * thresholds actually used by multiply(). Initialized to TOOM3_THRESHOLD and
+	 * TOOM4_THRESHOLD and can be changed at runtime for tuning
+	 */
+	extern std::size_t toom3_threshold;
+	extern std::size_t toom4_threshold;
+	/**
+	 * default length of the smaller array from which multiply() uses ntt_multiply()
+	 */
+	const std::size_t NTT_THRESHOLD = 5000;
+	/**
+	 * threshold actually used by multiply(). Initialized to NTT_THRESHOLD and can be
+	 * changed at runtime for tuning
+	 */
+	extern std::size_t ntt_threshold;
+	/**
+	 * longest product (a_len + b_len) that ntt_multiply() computes with a single
+	 * transform. Longer products are split by Toom-4 first
+	 */
+	const std::size_t NTT_MAX_LEN = static_cast<std::size_t>(1) << 22;
+	/**
+	 * default array length from which RealNumber division uses newton_divide()
+	 * instead of the long division in divide()
+	 */
+	const std::size_t NEWTON_DIVISION_THRESHOLD = 1200;
+	/**
+	 * threshold actually used for choosing newton_divide(). Initialized to
+	 * NEWTON_DIVISION_THRESHOLD and can be changed at runtime for tuning
+	 */
+	extern std::size_t newton_division_threshold;
+	/**
+	 * default length of the smaller array from which the sub-products of
+	 * karatsuba_multiply(), toom3_multiply(), toom4_multiply() and the transforms of
+	 * ntt_multiply() (and of the squaring functions) are computed concurrently
+	 */
+	const std::size_t PARALLEL_THRESHOLD = 400;
+	/**
+	 * threshold actually used. Initialized to PARALLEL_THRESHOLD and can be
+	 * changed at runtime for tuning
+	 */
+	extern std::size_t parallel_threshold;
+	/**
+	 * Vector instruction sets for add(), subtract(), helpers::compare(),
+	 * helpers::less_or_equal() and helpers::is_zero(). On other processors and
+	 * compilers only SIMD_SCALAR, the plain loops, is available
+	 */
+	enum SimdLevel { SIMD_SCALAR, SIMD_SSE42, SIMD_AVX2 };
+	/**
+	 * best level the processor supports
+	 */
+	SimdLevel supported_simd_level();
+	/**
+	 * level actually used. Initialized to supported_simd_level() and can be
+	 * lowered at runtime for testing and tuning, but must never be set higher
+	 */
+	extern SimdLevel simd_level;
+
+	/**
+	 * Scratch memory for the temporaries of the arithmetic functions
+	 * Workspace is a bump allocator: allocate() hands out consecutive limbs from
+	 * large blocks, and memory is given back in LIFO order by releasing to a Mark,
+	 * usually through a Frame. Blocks are kept when memory is released, so once a
+	 * workspace has grown to the peak use of a calculation, repeating the
+	 * calculation doesn't allocate any heap memory, apart from the tasks of work
+	 * split across threads (see Parallel execution below).
+	 * Functions that need scratch memory take a Workspace as their last parameter,
+	 * which defaults to the thread-local Workspace::local().
+	 */
+	class Workspace {
+	public:
+		// smallest block allocated when the workspace grows
+		static const std::size_t MIN_BLOCK_LIMBS = 1024;
+		// position to which the workspace can be released
+		struct Mark {
+			std::size_t block;
+			std::size_t offset;
+			std::size_t in_use;
+		};
+		/**
+		 * releases everything allocated from the workspace during its lifetime
+		 */
+		class Frame {
+		public:
+			explicit Frame(Workspace& ws);
+			~Frame();
+		private:
+			Workspace& ws;
+			Mark mark;
+			Frame(const Frame&);
+			Frame& operator=(const Frame&);
+		};
+
+		Workspace();
+		// reserves initial_limbs up front
+		explicit Workspace(const std::size_t& initial_limbs);
+		~Workspace();
+		/**
+		 * returns uninitialized memory for len limbs, valid until the workspace
+		 * is released to a mark taken before this call
+		 */
+		limb* allocate(const std::size_t& len);
+		Mark get_mark() const;
+		void release(const Mark& mark);
+		// limbs currently allocated
+		std::size_t get_in_use() const;
+		// maximum number of limbs that have been in use at the same time
+		std::size_t get_peak() const;
+		void reset_peak();
+		// limbs reserved in all blocks
+		std::size_t get_capacity() const;
+		// workspace of the calling thread
+		static Workspace& local();
+	private:
+		struct Block {
+			limb* data;
+			std::size_t size;
+		};
+		std::vector<Block> blocks;
+		std::size_t current_block;
+		std::size_t offset;
+		std::size_t in_use;
+		std::size_t peak;
+		void add_block(const std::size_t& size);
+		Workspace(const Workspace&);
+		Workspace& operator=(const Workspace&);
+	};
+
+	/**
+	 * Parallel execution
+	 * Work is run by a pool of get_thread_count() - 1 worker threads, together
+	 * with the thread waiting for it. Each worker has its own queue of tasks: a
+	 * thread takes the task it queued last, and idle threads steal the oldest
+	 * task of another queue, which for recursive work is the largest one.
+	 * A task computes with scratch memory from Workspace::local() of the thread
+	 * that runs it. With 1 thread, tasks run right away on the calling thread
+	 * Each queued task is allocated on the heap. So with more than 1 thread,
+	 * which is the default on most processors, calculations that are said to
+	 * allocate no heap memory once their workspace has grown are free of heap
+	 * allocations only while no work is split, i.e. below parallel_threshold
+	 */
+	std::size_t get_thread_count();
+	// defined in array_arithmetic.cpp
+	class ThreadPool;
+	/**
+	 * threads used, including the calling thread. Defaults to the number of
+	 * hardware threads. 0 is taken as 1
+	 * Must not be called while tasks are running
+	 */
+	void set_thread_count(const std::size_t& threads);
+	/**
+	 * Tasks that are waited for together. Tasks can start tasks of their own
+	 * and wait for them. wait() runs queued tasks, of any group, until the group
+	 * has finished, so the waiting thread keeps working. It sleeps only while no
+	 * task is queued, until another thread queues one or the last task of the
+	 * group finishes
+	 */
+	class TaskGroup {
+	public:
+		TaskGroup();
+		// waits for tasks that are still running, ignoring their exceptions
+		~TaskGroup();
+		/**
+		 * queues task, which must stay valid until wait() returns. With 1 thread,
+		 * it runs right away
+		 */
+		void run(const std::function<void()>& task);
+		// returns when all tasks have finished, rethrowing the first exception of any task
+		void wait();
+	private:
+		std::atomic<std::size_t> pending;
+		std::exception_ptr error;
+		std::mutex error_mutex;
+		// runs task and records its exception
+		void execute(const std::function<void()>& task);
+		friend class ThreadPool;
+		TaskGroup(const TaskGroup&);
+		TaskGroup& operator=(const TaskGroup&);
+	};
 	/**
 	 * conversion functions
 	 */
 	namespace convert {
-		void from_int(const unsigned int& num, unsigned char* result, 
+		void from_int(const unsigned int& num, limb* result, 
 				const std::size_t& result_len);
-		unsigned int to_int(const unsigned char* arr, const std::size_t& arr_len);
+		unsigned int to_int(const limb* arr, const std::size_t& arr_len);
+		/**
+		 * number of limbs that is enough to hold 10^exponent
+		 */
+		std::size_t power_of_ten_len(const std::size_t& exponent);
+		/**
+		 * result gets 10^exponent, computed by repeated squaring
+		 * result_len must be at least power_of_ten_len(exponent)
+		 */
+		void power_of_ten(const std::size_t& exponent, limb* result, const std::size_t& result_len,
+				Workspace& ws = Workspace::local());
+		/**
+		 * Writes the decimal representation of the integer arr into the first
+		 * digits characters of result, padded with leading zeros. arr must be less
+		 * than 10^digits
+		 * arr is divided recursively by powers 10^(9 * 2^i) (divide and conquer),
+		 * and short pieces are converted 9 digits per limb division
+		 */
+		void to_decimal_digits(const limb* arr, const std::size_t& arr_len, char* result,
+				const std::size_t& digits, Workspace& ws = Workspace::local());
+		/**
+		 * Sets result to the integer whose decimal representation is the first
+		 * digits_len characters of digits. result_len must be at least
+		 * power_of_ten_len(digits_len)
+		 * Chunks of 9 digits are combined into limbs, and long inputs are split
+		 * recursively at powers 10^(9 * 2^i), with the halves combined by multiplication
+		 * Throws an exception if a char is found that isn't a digit
+		 */
+		void from_decimal_digits(const char* digits, const std::size_t& digits_len, limb* result,
+				const std::size_t& result_len, Workspace& ws = Workspace::local());
 		namespace helpers {
 			/**
 			 * Converts a string of decimal digits into an array
 			 * Throws an exception if a char is found that isn't a digit
 			 */
 			unsigned char* to_digit_array(const std::string& str);
+			/**
+			 * Same as above for the characters of str from position start on,
+			 * written into result, which must have length str.size() - start
+			 */
+			void to_digit_array(const std::string& str, const std::size_t& start, unsigned char* result);
 			/**
 			 * multiplies the decimal digit array in place and returns the
 			 * number now to the left of the decimal
 			 */
-			unsigned char times_radix(unsigned char* decimal_digits, 
+			limb times_radix(unsigned char* decimal_digits, 
 					const std::size_t& arr_len);
 			/**
 			 * multiplies in place the elements in an array representing RADIX fractional
 			 * digits by 10 to get the next digit in the decimal representation
 			 */
-			unsigned char times_ten(unsigned char* radix_digits, const std::size_t& arr_len);
+			unsigned char times_ten(limb* radix_digits, const std::size_t& arr_len);
 		}
 	}
 	namespace helpers {
@@ -56,27 +293,40 @@ namespace array_arithmetic {
 		 * the least significant (rightmost) digits in target are all set to 0
 		 * target doesn't need to have been initialized
 		 */
-		void copy_into(const unsigned char* source, unsigned char* target, const std::size_t&
+		void copy_into(const limb* source, limb* target, const std::size_t&
 				source_len, const std::size_t& target_len);
 		/**
 		 * Shift array to the right the given number of places. Substitutes 0 for the empty
 		 * places and drops the last places of the array
 		 */
-		void shift_right(unsigned char* arr, const size_t& places, const size_t& arr_size);
+		void shift_right(limb* arr, const size_t& places, const size_t& arr_size);
 		/**
 		 * Assumption:
 		 * arr1 and arr2 have the same length
 		 */
-		bool less_or_equal(const unsigned char* arr1, const unsigned char* arr2, 
+		bool less_or_equal(const limb* arr1, const limb* arr2, 
 																 const std::size_t& len);
+		/**
+		 * returns -1, 0 or 1 as arr1 is less than, equal to or greater than arr2
+		 * Assumption:
+		 * arr1 and arr2 have the same length
+		 */
+		int compare(const limb* arr1, const limb* arr2, const std::size_t& len);
+		/**
+		 * whether |arr1 - arr2| <= ulps units of the last limb of the shorter array,
+		 * the shorter array being extended with zeros. Decided from the leading
+		 * limbs that differ, without computing the difference
+		 */
+		bool within_ulps(const limb* arr1, const std::size_t& arr1_len, const limb* arr2,
+				const std::size_t& arr2_len, const limb& ulps);
 		/**
 		 * test array to see if it represents 0--i.e., all indices contain the value 0
 		 */
-		bool is_zero(const unsigned char* arr, const std::size_t& len);
+		bool is_zero(const limb* arr, const std::size_t& len);
 		/**
 		 * sets all values to 0
 		 */
-		void set_to_zero(unsigned char* arr, const std::size_t& len);
+		void set_to_zero(limb* arr, const std::size_t& len);
 
 		namespace division {
 			/**
@@ -90,20 +340,20 @@ namespace array_arithmetic {
 			 * operation)
 			 * returns a negative integer representing the number of places moved
 			 */
-			int align_dividend(unsigned char* dividend, const unsigned char* divisor, const size_t& len);
+			int align_dividend(limb* dividend, const limb* divisor, const size_t& len);
 			/**
 			 * shift divisor bitwise right until it is <= dividend. returns the number of places moved
 			 */
-			int align_divisor(const unsigned char* dividend, unsigned char* divisor, const std::size_t& len);
+			int align_divisor(const limb* dividend, limb* divisor, const std::size_t& len);
 			/**
 			 * align dividend then align divisor and return net result
 			 */
-			int align(unsigned char* dividend, unsigned char* divisor, const std::size_t& len);
+			int align(limb* dividend, limb* divisor, const std::size_t& len);
 			/**
 			 * readjust divisor as division continues
 			 * shifts divisor right until divisor <= dividend
 			 */
-			int readjust(const unsigned char* dividend, unsigned char* divisor, const std::size_t& len);
+			int readjust(const limb* dividend, limb* divisor, const std::size_t& len);
 		}
 	}
 	/**
@@ -112,71 +362,174 @@ namespace array_arithmetic {
 	namespace bits {
 		/**
 		 * returns a mask in which the given number of least significant bits are set
-		 * If bits_to_show >= 8, all bits will be set (255)
+		 * If bits_to_show >= LIMB_BITS, all bits will be set (RADIX_MINUS_ONE)
 		 */
-		unsigned char get_mask(const std::size_t& bits_to_show);
+		limb get_mask(const std::size_t& bits_to_show);
 		/**
 		 * shift the array bits to the right
 		 */
-		void shift_right(unsigned char* arr, const std::size_t& places, const std::size_t& arr_size);
+		void shift_right(limb* arr, const std::size_t& places, const std::size_t& arr_size);
 		/**
-		 * It is assumed that bit_to_set < arr_len * 8, where arr_len is the 
+		 * It is assumed that bit_to_set < arr_len * LIMB_BITS, where arr_len is the 
 		 * size of the input array (not known to the function)
 		 */
-		void set(unsigned char* arr, const size_t& bit_to_set);
+		void set(limb* arr, const size_t& bit_to_set);
 	}
 	
 	/**
 	 * Assumptions:
 	 * 1) result has length a_len + b_len + 1
 	 * 2) b_len <= a_len
+	 * Reverts to school_multiply when b_len < karatsuba_threshold
 	 */
-	void karatsuba_multiply(const unsigned char* a, const unsigned char* b,
-			unsigned char* result, const std::size_t& a_len, const std::size_t& b_len);
+	void karatsuba_multiply(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len,
+			Workspace& ws = Workspace::local());
+
+	/**
+	 * Toom-Cook multiplication splitting the operands into 3 and 4 pieces
+	 * Sub-products are computed with multiply()
+	 * Assumptions:
+	 * 1) result has length a_len + b_len + 1
+	 * 2) b_len <= a_len
+	 */
+	void toom3_multiply(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len,
+			Workspace& ws = Workspace::local());
+	void toom4_multiply(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len,
+			Workspace& ws = Workspace::local());
+
+	/**
+	 * Exact multiplication by number theoretic transforms modulo 3 primes
+	 * Assumptions:
+	 * 1) result has length a_len + b_len + 1
+	 * 2) b_len <= a_len
+	 */
+	void ntt_multiply(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len,
+			Workspace& ws = Workspace::local());
+
+	/**
+	 * Multiplication using the algorithm that is fastest for the length of the
+	 * shorter operand: karatsuba_multiply() (which reverts to school_multiply())
+	 * below toom3_threshold, then Toom-3 below toom4_threshold, Toom-4 below
+	 * ntt_threshold and ntt_multiply() above.
+	 * If a is at least twice as long as b, b is multiplied with slices of a
+	 * Assumptions:
+	 * 1) result has length a_len + b_len + 1
+	 * 2) b_len <= a_len
+	 */
+	void multiply(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len,
+			Workspace& ws = Workspace::local());
+
+	/**
+	 * Fused sum and multiplication by a single limb, shifted right by whole limbs:
+	 * result = (a + b) * factor / RADIX^shift, computed in 1 pass and truncated
+	 * to len limbs. The carry out of the most significant limb is dropped.
+	 * b can be null, giving a * factor / RADIX^shift.
+	 * Assumption: a, b (if not null) and result all have length len. result can
+	 * be the same array as a or b
+	 */
+	void add_multiply_by_limb(const limb* a, const limb* b, const limb& factor,
+			const std::size_t& shift, limb* result, const std::size_t& len);
+
+	/**
+	 * Short product: sets result to the result_len most significant limbs of the
+	 * 2 * len + 1 limbs of a * b, computing only the limb products that reach
+	 * them plus 2 guard limbs. This takes about half the time of the full
+	 * product below karatsuba_threshold and 60-85% of it up to toom4_threshold,
+	 * beyond which the full product is computed.
+	 * Error bound: the products left out sum to less than len / RADIX in the
+	 * last limb of result, so result is either the exact leading limbs of
+	 * a * b or 1 less in the last limb
+	 * Assumptions:
+	 * 1) a and b have length len < RADIX / 2
+	 * 2) result_len <= 2 * len + 1
+	 */
+	void short_multiply(const limb* a, const limb* b, limb* result, const std::size_t& len,
+			const std::size_t& result_len, Workspace& ws = Workspace::local());
+
+	/**
+	 * Squaring kernels for each tier of multiply(). A square needs only about
+	 * half the limb products of a general product in school_square(), only 1
+	 * operand to split and evaluate in the Karatsuba and Toom-Cook recursions and
+	 * 2 instead of 3 transforms per prime in ntt_square()
+	 * square() chooses the kernel with the thresholds used by multiply(), and
+	 * multiply() calls it when a and b are the same array
+	 * Assumption: result has length 2 * len + 1
+	 */
+	void school_square(const limb* a, limb* result, const std::size_t& len);
+	void karatsuba_square(const limb* a, limb* result, const std::size_t& len,
+			Workspace& ws = Workspace::local());
+	void toom3_square(const limb* a, limb* result, const std::size_t& len,
+			Workspace& ws = Workspace::local());
+	void toom4_square(const limb* a, limb* result, const std::size_t& len,
+			Workspace& ws = Workspace::local());
+	void ntt_square(const limb* a, limb* result, const std::size_t& len,
+			Workspace& ws = Workspace::local());
+	void square(const limb* a, limb* result, const std::size_t& len,
+			Workspace& ws = Workspace::local());
 
 	/**
 	 * Assumptions:
 	 * 1) result must have length a_len + b_len + 1
 	 * 2) b_len <= a_len
 	 */
-	void school_multiply(const unsigned char* a, const unsigned char* b,
-			unsigned char* result, const std::size_t& a_len, const std::size_t& b_len); 
+	void school_multiply(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len); 
 
 	/**
 	 * This version uses NO OVERFLOW for the result!!!
 	 * All arrays are assumed to have the same length
 	 */
-	void add(const unsigned char* a, const unsigned char* b, unsigned char* result,
+	void add(const limb* a, const limb* b, limb* result,
 			const std::size_t& len);
 	/**
 	 * Assumptions:
 	 * 1) result has length a_len + 1
 	 * 2) b_len <= a_len
 	 */
-	void add(const unsigned char* a, const unsigned char* b,
-			unsigned char* result, const std::size_t& a_len, const std::size_t& b_len); 
+	void add(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len); 
 	/**
+	 * The borrow is carried from limb to limb without branching or scratch
+	 * memory, so result may be a or b
 	 * Assumptions:
 	 * 1) all arrays have the same size
 	 * 2) the number represented by b <= number represented by a
 	 */
-	void subtract(const unsigned char* a, const unsigned char* b, unsigned char* result,
+	void subtract(const limb* a, const limb* b, limb* result,
 			const std::size_t& len);
 	/**
+	 * result may be a
 	 * Assumptions:
 	 * 1) result is assumed to have length a_len
 	 * 2) b_len <= a_len
 	 * 3) the number represented by b <= number represented by a
 	 */
-	void subtract(const unsigned char* a, const unsigned char* b, unsigned char* result,
+	void subtract(const limb* a, const limb* b, limb* result,
 			const std::size_t& a_len, const std::size_t& b_len);
 	/**
+	 * Long division a limb at a time (Knuth's Algorithm D)
+	 * The quotient is truncated to the length of the arrays
 	 * Assumptions:
 	 * 1) dividend, divisor and result all have the same length
 	 * 2) It is NOT assumed that result has been initialized to 0
+	 * Throws invalid_argument if divisor is 0 and overflow_error if the
+	 * quotient doesn't fit in len limbs
 	 * @param int_digits We need to know how many digits represent integer places
 	 */
-	void divide(const unsigned char* dividend, const unsigned char* divisor, unsigned char* result,
-			const std::size_t& len, const std::size_t& int_digits);
+	void divide(const limb* dividend, const limb* divisor, limb* result,
+			const std::size_t& len, const std::size_t& int_digits, Workspace& ws = Workspace::local());
+	/**
+	 * Same as divide(), but computes a reciprocal of the divisor by Newton-Raphson
+	 * iteration, doubling the precision at each step, and multiplies by it.
+	 * Costs a small multiple of a karatsuba_multiply() of the same length
+	 * Throws the same exceptions as divide()
+	 */
+	void newton_divide(const limb* dividend, const limb* divisor, limb* result,
+			const std::size_t& len, const std::size_t& int_digits, Workspace& ws = Workspace::local());
 }
 #endif
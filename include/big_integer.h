@@ -0,0 +1,105 @@
+/**
+ * big_integer.h
+ * BigInteger
+ * Copyright (c) 2012 Marshall Farrier
+ * license http://opensource.org/licenses/gpl-license.php GNU Public License
+
+ * Signed integers of any size, for exact calculations such as the binary
+ * splitting of series, whose terms outgrow the integer part of RealNumber.
+ * The magnitude is stored in radix 2 ^ 32 with the most significant limb first,
+ * like RealNumber, and grows as needed. Arithmetic uses the array_arithmetic
+ * kernels, so long products use the same Karatsuba, Toom-Cook and NTT
+ * multiplication as RealNumber.
+ */
+
+#ifndef BIG_INTEGER_H
+#define BIG_INTEGER_H
+
+#include <string>
+#include <vector>
+
+#include "array_arithmetic.h"
+#include "real_number.h"
+
+class BigInteger {
+private:
+	// magnitude, most significant limb first, without leading zeros: 0 has no limbs
+	std::vector<array_arithmetic::limb> limbs;
+	// false for 0
+	bool negative;
+
+	// MEMBER PRIVATE HELPER METHODS
+	void remove_leading_zeros();
+	// returns a negative number, 0 or a positive number as |*this| <, = or > |num|
+	int compare_magnitude(const BigInteger& num) const;
+	// adds num, or -num if num_negative differs from the sign of num. num may be *this
+	void add(const BigInteger& num, const bool& num_negative);
+	/**
+	 * quotient and remainder, truncated toward 0 as for int. remainder has the
+	 * sign of *this. quotient or remainder can be null
+	 * throws std::invalid_argument if divisor is 0
+	 */
+	void divide(const BigInteger& divisor, BigInteger* quotient, BigInteger* remainder) const;
+
+public:
+	// 0
+	BigInteger();
+	explicit BigInteger(const long long& num);
+	/**
+	 * decimal integer with an optional leading '-'
+	 * throws std::invalid_argument if str isn't one
+	 */
+	explicit BigInteger(const std::string& str);
+	BigInteger(const BigInteger& num);
+	// takes over the storage of num, which is left as 0
+	BigInteger(BigInteger&& num);
+	BigInteger& operator=(const BigInteger& num);
+	BigInteger& operator=(BigInteger&& num);
+
+	/**
+	 * Conversion to and from RealNumber, in linear time
+	 * num * RADIX^(num.get_precision()), which is exact
+	 */
+	static BigInteger from_real_number(const RealNumber& num);
+	/**
+	 * *this / RADIX^fraction_limbs with the given precision, truncated
+	 * throws std::invalid_argument if *this is negative or the integer part of
+	 * the result is too big for RealNumber
+	 */
+	RealNumber to_real_number(const std::size_t& fraction_limbs,
+			const std::size_t& precision = RealNumber::PRECISION) const;
+	std::string to_decimal_string() const;
+
+	// number of limbs in the magnitude, 0 for 0
+	std::size_t size() const;
+	bool is_zero() const;
+	bool is_negative() const;
+
+	BigInteger operator-() const;
+	BigInteger& operator+=(const BigInteger& num);
+	BigInteger& operator-=(const BigInteger& num);
+	BigInteger& operator*=(const BigInteger& num);
+	// a single limb multiplies in 1 pass
+	BigInteger& operator*=(const array_arithmetic::limb& factor);
+	// division truncates toward 0, and a % b has the sign of a, as for int
+	// throws std::invalid_argument if the divisor is 0
+	BigInteger& operator/=(const BigInteger& divisor);
+	BigInteger& operator%=(const BigInteger& divisor);
+
+	friend bool operator==(const BigInteger& num, const BigInteger& num_to_compare);
+	friend bool operator<(const BigInteger& num, const BigInteger& num_to_compare);
+};
+
+BigInteger operator+(const BigInteger& a, const BigInteger& b);
+BigInteger operator-(const BigInteger& a, const BigInteger& b);
+BigInteger operator*(const BigInteger& a, const BigInteger& b);
+BigInteger operator/(const BigInteger& a, const BigInteger& b);
+BigInteger operator%(const BigInteger& a, const BigInteger& b);
+
+bool operator==(const BigInteger& num, const BigInteger& num_to_compare);
+bool operator!=(const BigInteger& num, const BigInteger& num_to_compare);
+bool operator<(const BigInteger& num, const BigInteger& num_to_compare);
+bool operator<=(const BigInteger& num, const BigInteger& num_to_compare);
+bool operator>(const BigInteger& num, const BigInteger& num_to_compare);
+bool operator>=(const BigInteger& num, const BigInteger& num_to_compare);
+#endif
@@ -9,17 +9,77 @@
 #ifndef CONVERGENT_SERIES_H
 #define CONVERGENT_SERIES_H
 
+#include <functional>
+
+#include "big_integer.h"
 #include "real_number.h"
 
 namespace ConvergentSeries {
+    // default depth of the binary splitting tree from which subtrees are evaluated serially
+    const size_t SPLITTING_SERIAL_DEPTH = 8;
+    // depth actually used. Initialized to SPLITTING_SERIAL_DEPTH and can be changed
+    // at runtime for tuning
+    extern size_t splitting_serial_depth;
+    // default precision in limbs from which gauss_legendre_pi() runs the independent
+    // operations of each iteration concurrently
+    const size_t TASK_GRAPH_THRESHOLD = 200;
+    // threshold actually used. Initialized to TASK_GRAPH_THRESHOLD and can be changed
+    // at runtime for tuning
+    extern size_t task_graph_threshold;
+    // Terms of a series sum_k t(k) / (q(0) ... q(k)) * p(0) ... p(k - 1) for binary
+    // splitting, as exact integers. The functions are called concurrently, so they
+    // must not change any shared state
+    struct SeriesTerms {
+        std::function<BigInteger(const size_t&)> p;
+        std::function<BigInteger(const size_t&)> q;
+        std::function<BigInteger(const size_t&)> t;
+    };
+    // sum of the terms 0 <= k < n as t / q: the binary splitting tree of products
+    // P = p(a) ... p(b - 1), Q = q(a) ... q(b - 1) and T = T_left Q_right + P_left T_right.
+    // Above splitting_serial_depth, the 2 subtrees of each node and the products that
+    // combine them are computed concurrently on the array_arithmetic thread pool
+    // Assumption: n > 0
+    void binary_splitting(const SeriesTerms& terms, const size_t& n, BigInteger& q, BigInteger& t);
     RealNumber babylonian_sqrt(const RealNumber& num, const RealNumber& guess, 
                                const size_t& iterations);
+    // square root at the precision of num, without a guess or an iteration count:
+    // babylonian steps from the double estimate, each at twice the precision of the
+    // one before, then at full precision until the result no longer changes
+    RealNumber babylonian_sqrt(const RealNumber& num);
+    // 1 / sqrt(num) at the precision of num by Newton's iteration
+    // y += y * (1 - num * y^2) / 2, which only multiplies, with the same precision
+    // doubling and stopping rule as babylonian_sqrt(num)
+    // For num < 1 the result has the error of num's last limb multiplied by about
+    // num^(-3/2) / 2, so it is within the tolerance of equals() only near 1 and above
+    // throws std::invalid_argument if num is 0 or 1 / sqrt(num) doesn't fit in
+    // the integer part
+    RealNumber inv_sqrt(const RealNumber& num);
+    // square root without division: num * inv_sqrt(num), with 1 correction step
+    // for num > 1
+    // numbers too small for inv_sqrt() use babylonian_sqrt(num)
+    RealNumber sqrt(const RealNumber& num);
     // 4 pi iterations with 10 sqrt iterations and sqrt 2 using 10 iterations and a guess of
     // 1.4 gives accuracy to 45 decimal digits
     // 5 pi iterations gives accuracy to 83 decimal digits
     // 6 iterations is accurate to 100+ digits
+    // The calculation uses the precision of sqrt_two
+    // From task_graph_threshold limbs, each iteration is a RealTaskGraph in which
+    // a + b runs concurrently with a * b, a - a_next with 2 * p, and the square root
+    // with the update of t
     RealNumber gauss_legendre_pi(const size_t& pi_iterations, const size_t& sqrt_iterations,
                                  const RealNumber& sqrt_two);
+    // the same with the given precision in limbs and without division, except for
+    // the last one: the square roots are computed by inv_sqrt() iterations that stop
+    // by themselves, starting from the inverse square root of the iteration before.
+    // Iterations run as above
+    RealNumber gauss_legendre_pi(const size_t& pi_iterations, const size_t& limbs);
+    // pi with the given precision in limbs from the Chudnovsky series, which adds
+    // about 14 decimal digits per term. The sum is computed exactly by binary
+    // splitting into integers P, Q and T, and then takes 1 division and 1 square root
+    RealNumber chudnovsky_pi(const size_t& limbs);
+    // e = sum 1 / k! with the given precision in limbs, by binary_splitting() and
+    // 1 division
+    RealNumber e(const size_t& limbs);
 }
 
 #endif
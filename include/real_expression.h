@@ -0,0 +1,317 @@
+/**
+ * real_expression.h
+ * Expression templates for RealNumber arithmetic
+ * Included at the end of real_number.h, so code using RealNumber gets
+ * them without any change.
+ *
+ * a + b, a - b and a * b return expression objects that refer to their operands
+ * and are evaluated only when assigned to or converted into a RealNumber.
+ * Evaluation works on limb arrays: operands that are expressions themselves
+ * are evaluated into scratch memory from array_arithmetic::Workspace::local(),
+ * so a chain like t - p * x needs no RealNumber temporaries, and the product is
+ * combined with t in the same pass that writes the result (fused multiply-add
+ * and multiply-subtract).
+ * A factor that is a RealNumber with a single nonzero limb, such as 0.5, 2.0 or
+ * 4.0, multiplies in 1 linear pass instead of a full multiplication, and a sum
+ * multiplied by such a factor, like (a + b) * one_half, is added and scaled in
+ * the same pass.
+ * Division is evaluated right away, since it can throw.
+ *
+ * Expressions have the const members of RealNumber, so (a + b).to_decimal_string()
+ * or (a * b).equals(c) evaluate the expression and call the member.
+ * Named RealNumber operands are referenced, while temporary ones, like the
+ * result of a.square() in a + a.square(), are moved into the expression. So
+ * an expression stored in an auto variable stays valid as long as its named
+ * operands, but it is evaluated again each time it is used
+ *
+ * Copyright (c) 2012 Marshall Farrier
+ * license http://opensource.org/licenses/gpl-license.php GNU Public License
+ */
+
+#ifndef REAL_EXPRESSION_H
+#define REAL_EXPRESSION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include "real_number.h"
+#include "array_arithmetic.h"
+
+/**
+ * RealNumber operands are stored by reference, expressions by value, so that
+ * temporary subexpressions live as long as the expression that contains them
+ */
+template <class E>
+struct RealOperand {
+	typedef const E type;
+};
+
+template <>
+struct RealOperand<RealNumber> {
+	typedef const RealNumber& type;
+};
+
+// a temporary RealNumber operand, owned by the expression that contains it
+class RealTemporary : public RealExpression<RealTemporary> {
+public:
+	explicit RealTemporary(RealNumber&& num) : value(std::move(num)) {}
+	std::size_t get_precision() const { return value.get_precision(); }
+	void evaluate(array_arithmetic::limb* result, const std::size_t& precision,
+			array_arithmetic::Workspace& ws) const {
+		array_arithmetic::Workspace::Frame frame(ws);
+		const array_arithmetic::limb* x = RealNumber::operand_limbs(value, precision, ws);
+		std::copy(x, x + RealNumber::INTEGER_DIGITS + precision, result);
+	}
+
+private:
+	RealNumber value;
+};
+
+/**
+ * Each expression provides
+ * 1) get_precision(): the larger of the precisions of its operands
+ * 2) evaluate(result, precision, ws): writes the value, extended to the given
+ * precision, into result, which has INTEGER_DIGITS + precision limbs and may be
+ * the storage of one of the operands
+ */
+template <class L, class R>
+class RealSum : public RealExpression<RealSum<L, R> > {
+public:
+	RealSum(const L& left_operand, const R& right_operand) : left(left_operand), right(right_operand) {}
+	std::size_t get_precision() const {
+		return left.get_precision() > right.get_precision() ? left.get_precision() : right.get_precision();
+	}
+	void evaluate(array_arithmetic::limb* result, const std::size_t& precision,
+			array_arithmetic::Workspace& ws) const {
+		array_arithmetic::Workspace::Frame frame(ws);
+		const array_arithmetic::limb* x = RealNumber::operand_limbs(left, precision, ws);
+		const array_arithmetic::limb* y = RealNumber::operand_limbs(right, precision, ws);
+		array_arithmetic::add(x, y, result, RealNumber::INTEGER_DIGITS + precision);
+	}
+	// (left + right) * factor / RADIX^shift in 1 pass
+	void evaluate_scaled(const array_arithmetic::limb& factor, const std::size_t& shift,
+			array_arithmetic::limb* result, const std::size_t& precision,
+			array_arithmetic::Workspace& ws) const {
+		array_arithmetic::Workspace::Frame frame(ws);
+		const array_arithmetic::limb* x = RealNumber::operand_limbs(left, precision, ws);
+		const array_arithmetic::limb* y = RealNumber::operand_limbs(right, precision, ws);
+		array_arithmetic::add_multiply_by_limb(x, y, factor, shift, result,
+				RealNumber::INTEGER_DIGITS + precision);
+	}
+
+private:
+	typename RealOperand<L>::type left;
+	typename RealOperand<R>::type right;
+};
+
+// left - right is undefined if right > left
+template <class L, class R>
+class RealDifference : public RealExpression<RealDifference<L, R> > {
+public:
+	RealDifference(const L& left_operand, const R& right_operand) : left(left_operand), right(right_operand) {}
+	std::size_t get_precision() const {
+		return left.get_precision() > right.get_precision() ? left.get_precision() : right.get_precision();
+	}
+	void evaluate(array_arithmetic::limb* result, const std::size_t& precision,
+			array_arithmetic::Workspace& ws) const {
+		array_arithmetic::Workspace::Frame frame(ws);
+		const array_arithmetic::limb* x = RealNumber::operand_limbs(left, precision, ws);
+		const array_arithmetic::limb* y = RealNumber::operand_limbs(right, precision, ws);
+		array_arithmetic::subtract(x, y, result, RealNumber::INTEGER_DIGITS + precision);
+	}
+
+private:
+	typename RealOperand<L>::type left;
+	typename RealOperand<R>::type right;
+};
+
+/**
+ * The product is a short product, like RealNumber multiplication, or a square
+ * if both operands are the same array. A factor with a single nonzero limb
+ * gives the exact truncated product in 1 pass
+ */
+template <class L, class R>
+class RealProduct : public RealExpression<RealProduct<L, R> > {
+public:
+	RealProduct(const L& left_operand, const R& right_operand) : left(left_operand), right(right_operand) {}
+	std::size_t get_precision() const {
+		return left.get_precision() > right.get_precision() ? left.get_precision() : right.get_precision();
+	}
+	void evaluate(array_arithmetic::limb* result, const std::size_t& precision,
+			array_arithmetic::Workspace& ws) const {
+		array_arithmetic::limb factor;
+		std::size_t shift;
+		if (RealNumber::single_limb(right, factor, shift)) {
+			scale(left, factor, shift, result, precision, ws);
+			return;
+		}
+		if (RealNumber::single_limb(left, factor, shift)) {
+			scale(right, factor, shift, result, precision, ws);
+			return;
+		}
+		array_arithmetic::Workspace::Frame frame(ws);
+		const array_arithmetic::limb* x = RealNumber::operand_limbs(left, precision, ws);
+		const array_arithmetic::limb* y = RealNumber::operand_limbs(right, precision, ws);
+		RealNumber::multiply_limbs(x, y, result, precision, ws);
+	}
+
+private:
+	typename RealOperand<L>::type left;
+	typename RealOperand<R>::type right;
+
+	template <class E>
+	static void scale(const E& operand, const array_arithmetic::limb& factor, const std::size_t& shift,
+			array_arithmetic::limb* result, const std::size_t& precision, array_arithmetic::Workspace& ws) {
+		array_arithmetic::Workspace::Frame frame(ws);
+		const array_arithmetic::limb* x = RealNumber::operand_limbs(operand, precision, ws);
+		array_arithmetic::add_multiply_by_limb(x, 0, factor, shift, result,
+				RealNumber::INTEGER_DIGITS + precision);
+	}
+	// a sum is added and scaled in the same pass
+	template <class A, class B>
+	static void scale(const RealSum<A, B>& operand, const array_arithmetic::limb& factor,
+			const std::size_t& shift, array_arithmetic::limb* result, const std::size_t& precision,
+			array_arithmetic::Workspace& ws) {
+		operand.evaluate_scaled(factor, shift, result, precision, ws);
+	}
+};
+
+template <class L, class R>
+RealSum<L, R> operator+(const RealExpression<L>& left, const RealExpression<R>& right) {
+	return RealSum<L, R>(left.self(), right.self());
+}
+
+template <class L, class R>
+RealDifference<L, R> operator-(const RealExpression<L>& left, const RealExpression<R>& right) {
+	return RealDifference<L, R>(left.self(), right.self());
+}
+
+template <class L, class R>
+RealProduct<L, R> operator*(const RealExpression<L>& left, const RealExpression<R>& right) {
+	return RealProduct<L, R>(left.self(), right.self());
+}
+
+// operators with temporary RealNumber operands
+template <class R>
+RealSum<RealTemporary, R> operator+(RealNumber&& left, const RealExpression<R>& right) {
+	return RealSum<RealTemporary, R>(RealTemporary(std::move(left)), right.self());
+}
+
+template <class L>
+RealSum<L, RealTemporary> operator+(const RealExpression<L>& left, RealNumber&& right) {
+	return RealSum<L, RealTemporary>(left.self(), RealTemporary(std::move(right)));
+}
+
+inline RealSum<RealTemporary, RealTemporary> operator+(RealNumber&& left, RealNumber&& right) {
+	return RealSum<RealTemporary, RealTemporary>(RealTemporary(std::move(left)), RealTemporary(std::move(right)));
+}
+
+template <class R>
+RealDifference<RealTemporary, R> operator-(RealNumber&& left, const RealExpression<R>& right) {
+	return RealDifference<RealTemporary, R>(RealTemporary(std::move(left)), right.self());
+}
+
+template <class L>
+RealDifference<L, RealTemporary> operator-(const RealExpression<L>& left, RealNumber&& right) {
+	return RealDifference<L, RealTemporary>(left.self(), RealTemporary(std::move(right)));
+}
+
+inline RealDifference<RealTemporary, RealTemporary> operator-(RealNumber&& left, RealNumber&& right) {
+	return RealDifference<RealTemporary, RealTemporary>(RealTemporary(std::move(left)),
+			RealTemporary(std::move(right)));
+}
+
+template <class R>
+RealProduct<RealTemporary, R> operator*(RealNumber&& left, const RealExpression<R>& right) {
+	return RealProduct<RealTemporary, R>(RealTemporary(std::move(left)), right.self());
+}
+
+template <class L>
+RealProduct<L, RealTemporary> operator*(const RealExpression<L>& left, RealNumber&& right) {
+	return RealProduct<L, RealTemporary>(left.self(), RealTemporary(std::move(right)));
+}
+
+inline RealProduct<RealTemporary, RealTemporary> operator*(RealNumber&& left, RealNumber&& right) {
+	return RealProduct<RealTemporary, RealTemporary>(RealTemporary(std::move(left)),
+			RealTemporary(std::move(right)));
+}
+
+// throws std::invalid_argument if divisor is 0
+template <class L, class R>
+RealNumber operator/(const RealExpression<L>& dividend, const RealExpression<R>& divisor) {
+	const std::size_t P = dividend.self().get_precision() > divisor.self().get_precision()
+			? dividend.self().get_precision() : divisor.self().get_precision();
+	RealNumber result(P);
+	array_arithmetic::Workspace& ws = array_arithmetic::Workspace::local();
+	array_arithmetic::Workspace::Frame frame(ws);
+	const array_arithmetic::limb* x = RealNumber::operand_limbs(dividend.self(), P, ws);
+	const array_arithmetic::limb* y = RealNumber::operand_limbs(divisor.self(), P, ws);
+	RealNumber::divide_limbs(x, y, result.value, P, ws);
+	return result;
+}
+
+// RealNumber members that take expressions
+template <class E>
+RealNumber::RealNumber(const RealExpression<E>& expression) : precision(expression.self().get_precision()) {
+	allocate();
+	expression.self().evaluate(value, precision, array_arithmetic::Workspace::local());
+}
+
+template <class E>
+RealNumber& RealNumber::operator=(const RealExpression<E>& expression) {
+	// an operand that is *this keeps its value when extended to the new precision
+	set_precision(expression.self().get_precision());
+	expression.self().evaluate(value, precision, array_arithmetic::Workspace::local());
+	return *this;
+}
+
+template <class E>
+RealNumber& RealNumber::operator+=(const RealExpression<E>& expression) {
+	return *this = *this + expression;
+}
+
+template <class E>
+RealNumber& RealNumber::operator-=(const RealExpression<E>& expression) {
+	return *this = *this - expression;
+}
+
+template <class E>
+RealNumber& RealNumber::operator*=(const RealExpression<E>& expression) {
+	return *this = *this * expression;
+}
+
+// RealNumber members of expressions, on the evaluated expression
+template <class E>
+std::size_t RealExpression<E>::get_decimal_precision() const {
+	return RealNumber(self()).get_decimal_precision();
+}
+
+template <class E>
+double RealExpression<E>::to_double() const { return RealNumber(self()).to_double(); }
+
+template <class E>
+std::string RealExpression<E>::to_decimal_string() const { return RealNumber(self()).to_decimal_string(); }
+
+template <class E>
+bool RealExpression<E>::equals(const RealNumber& num_to_compare) const {
+	return RealNumber(self()).equals(num_to_compare);
+}
+
+template <class E>
+RealNumber RealExpression<E>::difference(const RealNumber& num_to_subtract) const {
+	return RealNumber(self()).difference(num_to_subtract);
+}
+
+template <class E>
+RealNumber RealExpression<E>::square() const { return RealNumber(self()).square(); }
+
+template <class E>
+const array_arithmetic::limb* RealNumber::operand_limbs(const RealExpression<E>& expression,
+		const std::size_t& precision, array_arithmetic::Workspace& ws) {
+	array_arithmetic::limb* result = ws.allocate(INTEGER_DIGITS + precision);
+	expression.self().evaluate(result, precision, ws);
+	return result;
+}
+#endif
@@ -8,27 +8,18 @@
  * The integral part supported in this class is up to
  * 999,999,999 (9 decimal digits)
  * It is designed to support whatever precision is set for
- * the fractional part, which is converted to radix 256
- * (using an array of type unsigned char) for fast and efficient
- * calcuations, while allowing the use of unsigned int to 
+ * the fractional part, which is converted to radix 2 ^ 32
+ * (using an array of 32-bit limbs) for fast and efficient
+ * calcuations, while allowing the use of 64-bit intermediates to 
  * take care of the temporary overflow during mathematical operations.
  
  * Real numbers on this implementation are unsigned but do support subtraction.
  * If subtraction is used, the client is responsible for making sure that
  * for a - b, a >= b. Behavior for a < b is undefined.
  
- * The current (5/26/2012) implementation doesn't support
- * truly arbitrary precision (limited only by hardware): Multiplication 
- * requires that we sum PRECISION values of up to 255, plus a carry. That means
- * that PRECISION * 255 must be < 4294967295, which will be the case if 
- * PRECISION * 2 ^ 8 <= 2 ^ 32, i.e.
- * PRECISION  <= 2 ^ 24 =  16,777,216
- * Note that using a long doesn't change anything fundamentally, as long is not
- * actually guaranteed to be more than 32 bits:
- * http://www.cplusplus.com/doc/tutorial/variables/
- * Multiplication by the school method as implemented here will also require
- * PRECISION ^ 2 bytes of storage, which should be fine when PRECISION < 1000, but
- * even at 10,000 we are then using 100MB of memory.
+ * Multiplication propagates the carry after every limb product, and
+ * (2 ^ 32 - 1) ^ 2 + 2 * (2 ^ 32 - 1) < 2 ^ 64, so no sum of products can
+ * overflow the 64-bit intermediates, whatever the PRECISION.
  */
 
 #ifndef REAL_NUMBER_H
@@ -36,68 +27,285 @@
 
 #include <string>
 
-class RealNumber {
+#include "array_arithmetic.h"
+
+class RealNumber;
+
+/**
+ * Base of RealNumber and of the expressions in real_expression.h, which
+ * are built by +, - and * and evaluated when they are assigned
+ * E is the derived class (curiously recurring template pattern)
+ * The const members of RealNumber are also members of every expression,
+ * which evaluates itself and calls them, so (a + b).to_decimal_string()
+ * works as it does for a RealNumber. RealNumber's own members hide these
+ */
+template <class E>
+class RealExpression {
+public:
+	const E& self() const { return static_cast<const E&>(*this); }
+	std::size_t get_decimal_precision() const;
+	double to_double() const;
+	std::string to_decimal_string() const;
+	bool equals(const RealNumber& num_to_compare) const;
+	RealNumber difference(const RealNumber& num_to_subtract) const;
+	RealNumber square() const;
+};
+
+template <class L, class R> class RealSum;
+template <class L, class R> class RealDifference;
+template <class L, class R> class RealProduct;
+class RealTemporary;
+
+class RealNumber : public RealExpression<RealNumber> {
 public:
-	// determines digits of fractional part
-	static const unsigned int PRECISION = 50;
-	// 2.40823996 ~ log10(256)
-	static const unsigned int DECIMAL_PRECISION = PRECISION * 2.40823996;
+	// default number of limbs in the fractional part
+	static const unsigned int PRECISION = 13;
+	// 9.63295986 ~ log10(2 ^ 32)
+	static const unsigned int DECIMAL_PRECISION = PRECISION * 9.63295986;
 	static const unsigned int MAX_DECIMAL_INTEGER_DIGITS = 9;
-	// first 4 digits in value array represent the integer part
-	static const unsigned int INTEGER_DIGITS = 4;
-	static const unsigned int ARRAY_SIZE = INTEGER_DIGITS + PRECISION;
-	static const unsigned int ARRAY_BITS = ARRAY_SIZE * 8;
+	// first limb in value array represents the integer part
+	static const unsigned int INTEGER_DIGITS = 1;
 	static const unsigned int BITS_FOR_EQUALITY = 4;
+	// largest difference, in units of the last limb, for which equals() is true
+	static const array_arithmetic::limb EQUALITY_TOLERANCE = (1u << BITS_FOR_EQUALITY) - 1;
+	// numbers with array size up to INLINE_LIMBS don't allocate any heap memory
+	static const unsigned int INLINE_LIMBS = INTEGER_DIGITS + PRECISION + 2;
 
 private:
-	// array will be of size INTEGER_DIGITS + PRECISION
-	unsigned char* value;
+	// number of limbs in the fractional part of this object
+	std::size_t precision;
+	// array will be of size INTEGER_DIGITS + precision
+	// points to inline_value or, for large precisions, to heap memory
+	array_arithmetic::limb* value;
+	array_arithmetic::limb inline_value[INLINE_LIMBS];
 
 	// MEMBER PRIVATE HELPER METHODS
 	void init();
+	// point value to storage of size array_size() without initializing it
+	void allocate();
+	// free heap storage if there is any
+	void release();
+	bool is_inline() const;
+	// leave a moved-from object as a valid 0 with precision 0
+	void reset_moved();
+	std::size_t array_size() const;
 	// set integer places in value using an int input
 	void set_integer_part(const int& integer_part);
 	// convert the integer part of value array to an int
 	unsigned int get_integer_part() const;
+	/**
+	 * returns a negative number if *this < num_to_compare, 0 if they are equal
+	 * and a positive number if *this > num_to_compare
+	 */
+	int compare(const RealNumber& num_to_compare) const;
+	/**
+	 * arithmetic with scratch memory from ws
+	 * Assumption: operands and result all have the same precision
+	 * result may be the same object as an operand
+	 */
+	void multiply(const RealNumber& multiplier, RealNumber& result,
+			array_arithmetic::Workspace& ws) const;
+	void square(RealNumber& result, array_arithmetic::Workspace& ws) const;
+	void divide(const RealNumber& divisor, RealNumber& result, array_arithmetic::Workspace& ws) const;
+	/**
+	 * arithmetic on value arrays of INTEGER_DIGITS + precision limbs, for RealNumber
+	 * and the expression templates. result may be the same array as an operand.
+	 * multiply_limbs() squares if a and b are the same array
+	 */
+	static void multiply_limbs(const array_arithmetic::limb* a, const array_arithmetic::limb* b,
+			array_arithmetic::limb* result, const std::size_t& precision, array_arithmetic::Workspace& ws);
+	static void divide_limbs(const array_arithmetic::limb* a, const array_arithmetic::limb* b,
+			array_arithmetic::limb* result, const std::size_t& precision, array_arithmetic::Workspace& ws);
+	/**
+	 * value array of an operand at the given precision, which is at least
+	 * the precision of the operand: the operand's own array or, for expressions
+	 * and less precise numbers, scratch memory from ws holding the value
+	 */
+	static const array_arithmetic::limb* operand_limbs(const RealNumber& num, const std::size_t& limbs,
+			array_arithmetic::Workspace& ws);
+	template <class E>
+	static const array_arithmetic::limb* operand_limbs(const RealExpression<E>& expression,
+			const std::size_t& limbs, array_arithmetic::Workspace& ws);
+	/**
+	 * true if num has at most 1 nonzero limb, which is then factor at
+	 * the given index. Expressions aren't checked
+	 */
+	static bool single_limb(const RealNumber& num, array_arithmetic::limb& factor, std::size_t& index);
+	template <class E>
+	static bool single_limb(const RealExpression<E>&, array_arithmetic::limb&, std::size_t&) { return false; }
+
+	friend class RealTemporary;
+	template <class L, class R> friend class RealSum;
+	template <class L, class R> friend class RealDifference;
+	template <class L, class R> friend class RealProduct;
+	template <class L, class R>
+	friend RealNumber operator/(const RealExpression<L>& dividend, const RealExpression<R>& divisor);
+	// converts from and to value arrays
+	friend class BigInteger;
+	std::string to_decimal_string(array_arithmetic::Workspace& ws) const;
     
 public:
+	/**
+	 * Precision
+	 * Every object has its own precision (limbs in the fractional part), which
+	 * defaults to PRECISION. Numbers of different precision can be mixed:
+	 * 1) +, -, *, / and difference() return a result with the larger of the 2
+	 * precisions. The less precise operand is extended with zeros.
+	 * 2) comparison operators compare the exact values, again extending
+	 * the less precise operand with zeros
+	 * 3) equals() uses the tolerance of the less precise operand
+	 * 4) the copy constructor and assignment operator copy the precision along
+	 * with the value
+	 */
 	RealNumber();
+	explicit RealNumber(const std::size_t& limbs);
 	RealNumber(const std::string& str);
+	RealNumber(const std::string& str, const std::size_t& limbs);
 	// copy constructor
 	RealNumber(const RealNumber& num);
+	/**
+	 * move constructor
+	 * takes over the heap storage of num, which is left as 0 with precision 0
+	 */
+	RealNumber(RealNumber&& num);
+	/**
+	 * copy of num with the given precision. Limbs beyond the new precision
+	 * are truncated, new limbs are set to 0
+	 */
+	RealNumber(const RealNumber& num, const std::size_t& limbs);
+	// evaluates an expression built by +, - and *, with its precision
+	template <class E>
+	RealNumber(const RealExpression<E>& expression);
 	~RealNumber();
+	/**
+	 * smallest precision (in limbs) representing at least the given
+	 * number of decimal digits after the decimal point
+	 */
+	static std::size_t precision_for_digits(const std::size_t& decimal_digits);
+	std::size_t get_precision() const;
+	// number of decimal digits after the decimal point in to_decimal_string()
+	std::size_t get_decimal_precision() const;
+	/**
+	 * nearest double below the value: its leading 53 bits, from the leading
+	 * nonzero limbs. Numbers smaller than the smallest double give 0
+	 */
+	double to_double() const;
+	/**
+	 * the given double, truncated to the given precision. A factory rather than
+	 * a constructor, since RealNumber(3) would be ambiguous with RealNumber(limbs)
+	 * throws std::invalid_argument if num is negative or too big for the integer part
+	 */
+	static RealNumber from_double(const double& num, const std::size_t& limbs = PRECISION);
+	/**
+	 * the number whose value array, most significant limb first, starts with
+	 * the len limbs of arr: arr[0] is the integer part. Limbs beyond the given
+	 * precision are truncated, missing ones are 0
+	 */
+	static RealNumber from_limbs(const array_arithmetic::limb* arr, const std::size_t& len,
+			const std::size_t& limbs = PRECISION);
+	/**
+	 * change the precision of the calling object, truncating or extending
+	 * the fractional part
+	 */
+	void set_precision(const std::size_t& limbs);
+	/**
+	 * peak scratch memory, in limbs, that an arithmetic operation or
+	 * to_decimal_string() uses at the given precision. Scratch memory comes from
+	 * array_arithmetic::Workspace::local(), so reserving this many limbs there
+	 * avoids any heap allocation by the operations. Sub-products that run on
+	 * other threads (see array_arithmetic::set_thread_count()) use the workspaces
+	 * of those threads, and each of them allocates its task, so this holds with
+	 * more than 1 thread only below array_arithmetic::parallel_threshold
+	 */
+	static std::size_t scratch_limbs(const std::size_t& limbs);
 	// output string represents value in decimal format
 	std::string to_decimal_string() const;
 	RealNumber& operator=(const RealNumber& num);
-	bool operator>(const RealNumber& num_to_compare) const;
-	bool operator>=(const RealNumber& num_to_compare) const;
-	bool operator<(const RealNumber& num_to_compare) const;
-	bool operator<=(const RealNumber& num_to_compare) const;
-	bool operator!=(const RealNumber& num_to_compare) const;
+	RealNumber& operator=(RealNumber&& num);
 	/**
-	 * True equality, which for real number calculations is inferior
-	 * to equals(), which determines appropximate equality
+	 * evaluates the expression directly into this object, which takes its
+	 * precision and may appear in the expression
 	 */
-	bool operator==(const RealNumber& num_to_compare) const;
+	template <class E>
+	RealNumber& operator=(const RealExpression<E>& expression);
+	/**
+	 * Comparison operators are friends, so that an expression on either side
+	 * is converted to a RealNumber. True equality (==), which for real number
+	 * calculations is inferior to equals(), which determines appropximate equality
+	 */
+	friend bool operator>(const RealNumber& num, const RealNumber& num_to_compare);
+	friend bool operator>=(const RealNumber& num, const RealNumber& num_to_compare);
+	friend bool operator<(const RealNumber& num, const RealNumber& num_to_compare);
+	friend bool operator<=(const RealNumber& num, const RealNumber& num_to_compare);
+	friend bool operator!=(const RealNumber& num, const RealNumber& num_to_compare);
+	friend bool operator==(const RealNumber& num, const RealNumber& num_to_compare);
 	/**
 	 * equality to within last BITS_FOR_EQUALITY
 	 * i.e., difference between 2 numbers is <= the number defined by setting
 	 * the last BITS_FOR_EQUALITY bits to 1 and all remaining bits to 0
+	 * Returns as soon as the leading limbs that differ decide it, without
+	 * allocating or subtracting
 	 */
 	bool equals(const RealNumber& num_to_compare) const;
-	RealNumber operator+(const RealNumber& num_to_add) const;
-	// a - b is undefined if b > a
-	RealNumber operator-(const RealNumber& num_to_subtract) const;
-	RealNumber operator*(const RealNumber& multiplier) const;
-	RealNumber operator/(const RealNumber& divisor) const;
+	/**
+	 * +, -, * and / are defined in real_expression.h. a - b is undefined if b > a.
+	 * The product is computed as a short product of the limbs that reach the
+	 * result, so it can be 1 less in the last limb than the truncated exact
+	 * product, well within the tolerance of equals()
+	 * x * x with the same object x is computed exactly as x.square()
+	 */
+	/**
+	 * compound assignment, computed in place
+	 */
+	template <class E>
+	RealNumber& operator+=(const RealExpression<E>& expression);
+	template <class E>
+	RealNumber& operator-=(const RealExpression<E>& expression);
+	template <class E>
+	RealNumber& operator*=(const RealExpression<E>& expression);
+	RealNumber& operator/=(const RealNumber& divisor);
 	/**
 	 * returns absolute value of difference and works regardless of
 	 * which number is larger
 	 */
 	RealNumber difference(const RealNumber& num_to_subtract) const;
+	/**
+	 * *this * *this, using the squaring kernels, which are faster than
+	 * a general multiplication
+	 */
+	RealNumber square() const;
 	/**
 	 * assigns calling object the value specified in the decimal string str
 	 */
 	void assign_value(const std::string& str);
+
+	friend void add(RealNumber& result, const RealNumber& a, const RealNumber& b);
+	friend void sub(RealNumber& result, const RealNumber& a, const RealNumber& b);
+	friend void mul(RealNumber& result, const RealNumber& a, const RealNumber& b);
+	friend void div(RealNumber& result, const RealNumber& a, const RealNumber& b);
 };
+
+bool operator>(const RealNumber& num, const RealNumber& num_to_compare);
+bool operator>=(const RealNumber& num, const RealNumber& num_to_compare);
+bool operator<(const RealNumber& num, const RealNumber& num_to_compare);
+bool operator<=(const RealNumber& num, const RealNumber& num_to_compare);
+bool operator!=(const RealNumber& num, const RealNumber& num_to_compare);
+bool operator==(const RealNumber& num, const RealNumber& num_to_compare);
+
+/**
+ * Arithmetic into a caller-owned result: result = a + b, a - b, a * b or a / b
+ * result takes the larger precision of a and b, and any of the 3 arguments can
+ * be the same object. Once result has that precision, nothing is allocated on
+ * the heap: scratch memory comes from array_arithmetic::Workspace::local().
+ * Only div() with operands of different precision needs a temporary. With more
+ * than 1 thread, precisions from array_arithmetic::parallel_threshold split the
+ * work into tasks, which are allocated
+ */
+void add(RealNumber& result, const RealNumber& a, const RealNumber& b);
+// a - b is undefined if b > a
+void sub(RealNumber& result, const RealNumber& a, const RealNumber& b);
+void mul(RealNumber& result, const RealNumber& a, const RealNumber& b);
+void div(RealNumber& result, const RealNumber& a, const RealNumber& b);
+
+#include "real_expression.h"
 #endif
@@ -0,0 +1,97 @@
+/**
+ * real_task_graph.h
+ * RealTaskGraph
+ * Copyright (c) 2012 Marshall Farrier
+ * license http://opensource.org/licenses/gpl-license.php GNU Public License
+
+ * Dataflow graphs of RealNumber operations. Each node is an operation, such as
+ * an assignment a_next = (a + b) * one_half, and lists the nodes whose results
+ * it needs. run() executes every node once its dependencies have finished, so
+ * operations that don't depend on each other run concurrently on the
+ * array_arithmetic thread pool, even at precisions where the thread pool
+ * wouldn't split a single multiplication.
+ * A graph is built once and can be run any number of times, for instance
+ * once per iteration of a loop, with the operands changing in between.
+ */
+
+#ifndef REAL_TASK_GRAPH_H
+#define REAL_TASK_GRAPH_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "array_arithmetic.h"
+#include "real_number.h"
+
+class RealTaskGraph {
+public:
+	typedef std::size_t Node;
+
+	RealTaskGraph();
+	/**
+	 * adds a node that runs operation after all of the given nodes. Nodes run
+	 * concurrently must not write anything that another of them reads or writes
+	 * throws std::invalid_argument if a dependency isn't a node added before
+	 */
+	Node add(const std::function<void()>& operation,
+			const std::vector<Node>& dependencies = std::vector<Node>());
+	/**
+	 * adds a node that evaluates expression into result. RealNumber operands are
+	 * referenced, not copied, so each run uses their values at the time and
+	 * they must outlive the graph
+	 */
+	template <class E>
+	Node assign(RealNumber& result, const RealExpression<E>& expression,
+			const std::vector<Node>& dependencies = std::vector<Node>());
+	// number of nodes
+	std::size_t size() const;
+	/**
+	 * runs every node once and returns when all have finished. If concurrent is
+	 * false or there is only 1 thread (see array_arithmetic::set_thread_count()),
+	 * the nodes run on the calling thread in the order in which they were added.
+	 * Otherwise the calling thread runs nodes too, along with the workers
+	 * If an operation throws, run() rethrows the first exception once the running
+	 * operations have finished. Nodes depending on the failed one never run, and
+	 * others may not either
+	 */
+	void run(const bool& concurrent = true);
+
+private:
+	struct Vertex {
+		std::function<void()> operation;
+		std::size_t dependency_count;
+		std::vector<Node> successors;
+	};
+	std::vector<Vertex> vertices;
+	// dependencies of each node that haven't finished yet during run()
+	std::unique_ptr<std::atomic<std::size_t>[]> remaining;
+	std::size_t remaining_size;
+	array_arithmetic::TaskGroup group;
+
+	// runs node and queues those of its successors that become ready
+	void execute(const Node& node);
+
+	RealTaskGraph(const RealTaskGraph&);
+	RealTaskGraph& operator=(const RealTaskGraph&);
+};
+
+// result = expression, with the expression held as in other expressions
+template <class E>
+class RealAssignment {
+public:
+	RealAssignment(RealNumber& result_number, const E& operand) : result(result_number), expression(operand) {}
+	void operator()() const { result = expression; }
+private:
+	RealNumber& result;
+	typename RealOperand<E>::type expression;
+};
+
+template <class E>
+RealTaskGraph::Node RealTaskGraph::assign(RealNumber& result, const RealExpression<E>& expression,
+		const std::vector<Node>& dependencies) {
+	return add(RealAssignment<E>(result, expression.self()), dependencies);
+}
+#endif
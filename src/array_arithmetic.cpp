@@ -13,57 +13,1059 @@
 #include <stdexcept>
 #include <string>
 #include <stdexcept>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
 
 #include "array_arithmetic.h"
 
+// vector kernels need x86 and the target attribute of gcc or clang
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ARRAY_ARITHMETIC_X86_SIMD
+#include <immintrin.h>
+#endif
+
 namespace array_arithmetic {
 	/**
 	 * for "private" methods
 	 */
 	namespace {
+		/**
+		 * adds x, shifted left by shift places, into result in place
+		 * result must be big enough to hold the sum. Leading zeros of x that would
+		 * fall outside of result are ignored
+		 */
+		void add_into(limb* result, const std::size_t& result_len, const limb* x,
+				const std::size_t& x_len, const std::size_t& shift) {
+			std::size_t skip = 0;
+			while (x_len - skip + shift > result_len) { ++skip; }
+			double_limb carry = 0, tmp_sum;
+			std::size_t i = x_len, j = result_len - shift;
+			while (i > skip) {
+				--i;
+				--j;
+				tmp_sum = carry + result[j] + x[i];
+				result[j] = static_cast<limb>(tmp_sum);
+				carry = tmp_sum >> LIMB_BITS;
+			}
+			while (carry > 0 && j > 0) {
+				--j;
+				tmp_sum = carry + result[j];
+				result[j] = static_cast<limb>(tmp_sum);
+				carry = tmp_sum >> LIMB_BITS;
+			}
+		}
+		/**
+		 * subtracts x from result in place
+		 * Assumptions:
+		 * 1) x_len <= result_len
+		 * 2) the number represented by x <= number represented by result
+		 */
+		void subtract_from(limb* result, const std::size_t& result_len, const limb* x,
+				const std::size_t& x_len) {
+			double_limb borrow = 0, tmp;
+			std::size_t i = x_len, j = result_len;
+			while (i > 0) {
+				--i;
+				--j;
+				tmp = x[i] + borrow;
+				borrow = result[j] < tmp;
+				result[j] = static_cast<limb>(RADIX + result[j] - tmp);
+			}
+			while (borrow > 0 && j > 0) {
+				--j;
+				borrow = result[j] == 0;
+				result[j] = static_cast<limb>(RADIX + result[j] - 1);
+			}
+		}
+		/**
+		 * true if work on operands of the given length is split into tasks: they
+		 * have at least parallel_threshold limbs and there is more than 1 thread
+		 */
+		bool split_work(const std::size_t& len) {
+			return len >= parallel_threshold && get_thread_count() > 1;
+		}
+		/**
+		 * Independent sub-products of a multiplication, each computed with scratch
+		 * memory of the thread that runs it: as tasks on the thread pool if
+		 * split_work(), else right away with ws
+		 */
+		class SubProducts {
+		public:
+			SubProducts(const std::size_t& len, Workspace& ws) : concurrent(split_work(len)), ws(ws) {}
+			// product is called with the Workspace to use
+			template <class F>
+			void run(const F& product) {
+				if (concurrent) { group.run([product] { product(Workspace::local()); }); }
+				else { product(ws); }
+			}
+			void wait() { group.wait(); }
+		private:
+			const bool concurrent;
+			Workspace& ws;
+			TaskGroup group;
+		};
+		/**
+		 * signature shared by the multiplication functions
+		 */
+		typedef void (*multiply_function)(const limb*, const limb*, limb*, const std::size_t&,
+				const std::size_t&, Workspace&);
+		/**
+		 * multiply an array much longer than b by multiplying b with successive
+		 * slices of a of length b_len, using the given multiplication function
+		 * result is assumed to have length a_len + b_len + 1
+		 */
+		void multiply_slices(const limb* a, const limb* b, limb* result, const std::size_t& a_len,
+				const std::size_t& b_len, multiply_function slice_multiply, Workspace& ws) {
+			const std::size_t RESULT_LEN = a_len + b_len + 1;
+			Workspace::Frame frame(ws);
+			limb* product = ws.allocate(2 * b_len + 1);
+			helpers::set_to_zero(result, RESULT_LEN);
+			std::size_t shift = 0, slice_len;
+			while (shift < a_len) {
+				slice_len = a_len - shift < b_len ? a_len - shift : b_len;
+				if (slice_len == b_len) {
+					slice_multiply(a + a_len - shift - slice_len, b, product, slice_len, b_len, ws);
+				}
+				else {
+					slice_multiply(b, a + a_len - shift - slice_len, product, b_len, slice_len, ws);
+				}
+				add_into(result, RESULT_LEN, product, slice_len + b_len + 1, shift);
+				shift += slice_len;
+			}
+		}
+		/**
+		 * multiply() for operands in either order
+		 * result is assumed to have length a_len + b_len + 1
+		 */
+		void multiply_any(const limb* a, const limb* b, limb* result,
+				const std::size_t& a_len, const std::size_t& b_len, Workspace& ws) {
+			if (b_len <= a_len) { multiply(a, b, result, a_len, b_len, ws); }
+			else { multiply(b, a, result, b_len, a_len, ws); }
+		}
+		/**
+		 * skips leading zero limbs of arr, leaving at least 1 limb
+		 */
+		void trim(const limb*& arr, std::size_t& len) {
+			while (len > 1 && arr[0] == 0) {
+				++arr;
+				--len;
+			}
+		}
+		/**
+		 * returns a negative number, 0 or a positive number as a is less than,
+		 * equal to or greater than b. The arrays can have different lengths
+		 */
+		int compare(const limb* a, const std::size_t& a_len, const limb* b, const std::size_t& b_len) {
+			std::size_t i = 0, j = 0;
+			for ( ; a_len - i > b_len; ++i) {
+				if (a[i] != 0) { return 1; }
+			}
+			for ( ; b_len - j > a_len; ++j) {
+				if (b[j] != 0) { return -1; }
+			}
+			for ( ; i < a_len; ++i, ++j) {
+				if (a[i] != b[j]) { return a[i] < b[j] ? -1 : 1; }
+			}
+			return 0;
+		}
+		/**
+		 * multiplies arr in place by factor and returns the carry
+		 */
+		limb multiply_by_limb(limb* arr, const std::size_t& len, const limb& factor) {
+			double_limb carry = 0, tmp;
+			std::size_t i = len;
+			while (i > 0) {
+				--i;
+				tmp = carry + static_cast<double_limb>(arr[i]) * factor;
+				arr[i] = static_cast<limb>(tmp);
+				carry = tmp >> LIMB_BITS;
+			}
+			return static_cast<limb>(carry);
+		}
+		/**
+		 * divides arr in place by divisor and returns the remainder
+		 */
+		limb divide_by_limb(limb* arr, const std::size_t& len, const limb& divisor) {
+			double_limb remainder = 0, tmp;
+			for (std::size_t i = 0; i < len; ++i) {
+				tmp = (remainder << LIMB_BITS) | arr[i];
+				arr[i] = static_cast<limb>(tmp / divisor);
+				remainder = tmp % divisor;
+			}
+			return static_cast<limb>(remainder);
+		}
+		/**
+		 * divides arr in place by divisor, which must divide it exactly
+		 * Odd divisors are handled by multiplying with the inverse of the divisor
+		 * modulo RADIX, from the least significant limb up, which avoids hardware division
+		 */
+		void divide_exact_by_limb(limb* arr, const std::size_t& len, const limb& divisor) {
+			limb odd = divisor;
+			std::size_t twos = 0;
+			while ((odd & 1) == 0) {
+				odd >>= 1;
+				++twos;
+			}
+			if (twos > 0) { bits::shift_right(arr, twos, len); }
+			if (odd == 1) { return; }
+			// Newton iteration for the inverse doubles the number of correct bits from 3
+			limb inverse = odd;
+			for (int i = 0; i < 4; ++i) { inverse *= 2 - odd * inverse; }
+			limb borrow = 0, underflow, quotient;
+			std::size_t i = len;
+			while (i > 0) {
+				--i;
+				underflow = arr[i] < borrow;
+				quotient = static_cast<limb>(arr[i] - borrow) * inverse;
+				arr[i] = quotient;
+				borrow = static_cast<limb>((static_cast<double_limb>(quotient) * odd) >> LIMB_BITS) + underflow;
+			}
+		}
+		/**
+		 * subtracts factor * x from result in place
+		 * Assumptions as for subtract_from() with factor * x in place of x
+		 */
+		void subtract_multiple(limb* result, const std::size_t& result_len, const limb* x,
+				const std::size_t& x_len, const limb& factor) {
+			double_limb carry = 0, product, tmp;
+			std::size_t i = x_len, j = result_len;
+			while (i > 0) {
+				--i;
+				--j;
+				product = static_cast<double_limb>(x[i]) * factor + carry;
+				tmp = static_cast<limb>(product);
+				carry = (product >> LIMB_BITS) + (result[j] < tmp);
+				result[j] = static_cast<limb>(result[j] - tmp);
+			}
+			while (carry > 0 && j > 0) {
+				--j;
+				tmp = carry;
+				carry = result[j] < tmp;
+				result[j] = static_cast<limb>(result[j] - tmp);
+			}
+		}
+		/**
+		 * sets piece and piece_len to the piece of arr with index i when arr is split
+		 * into pieces of piece_size limbs, where the piece with index 0 holds the
+		 * least significant limbs. Pieces past the beginning of arr are empty
+		 */
+		void get_piece(const limb* arr, const std::size_t& len, const std::size_t& piece_size,
+				const std::size_t& i, const limb*& piece, std::size_t& piece_len) {
+			if (i * piece_size >= len) {
+				piece = arr;
+				piece_len = 0;
+				return;
+			}
+			const std::size_t END = len - i * piece_size;
+			piece_len = END < piece_size ? END : piece_size;
+			piece = arr + END - piece_len;
+		}
+		/**
+		 * sets result, of length result_len, to x * y, where either length can be 0
+		 * result_len must be at least x_len + y_len + 1
+		 */
+		void multiply_into(const limb* x, std::size_t x_len, const limb* y, std::size_t y_len,
+				limb* result, const std::size_t& result_len, Workspace& ws) {
+			if (x_len > 0) { trim(x, x_len); }
+			if (y_len > 0) { trim(y, y_len); }
+			if (x_len == 0 || y_len == 0) {
+				helpers::set_to_zero(result, result_len);
+				return;
+			}
+			const std::size_t PRODUCT_LEN = x_len + y_len + 1;
+			helpers::set_to_zero(result, result_len - PRODUCT_LEN);
+			multiply_any(x, y, result + result_len - PRODUCT_LEN, x_len, y_len, ws);
+		}
+		/**
+		 * adds x into result with x[0] at result[offset], dropping the limbs of x
+		 * that fall beyond the end of result
+		 */
+		void add_at(limb* result, const std::size_t& result_len, const limb* x,
+				const std::size_t& x_len, const std::size_t& offset) {
+			const std::size_t LEN = x_len < result_len - offset ? x_len : result_len - offset;
+			add_into(result, result_len, x, LEN, result_len - offset - LEN);
+		}
+		/**
+		 * sets result, of length diagonal + 3, to the sum of the limb products
+		 * a[i] * b[j] with i + j <= diagonal, placed as in the product a * b,
+		 * where the low limb of a[i] * b[j] is at index i + j + 2. Each product
+		 * of higher limbs is kept, so result is at most the high limbs of a * b
+		 * Below karatsuba_threshold the products are summed directly. Above it,
+		 * Mulders' method takes the full product of the leading k limbs of a and b,
+		 * with k > diagonal / 2, and the products of the rest of a with b and of
+		 * a with the rest of b are 2 disjoint triangles for diagonal - k.
+		 * Limbs of partial results beyond the end of result are dropped, losing
+		 * less than 1 in the last limb each time
+		 */
+		void high_product(const limb* a, std::size_t a_len, const limb* b, std::size_t b_len,
+				const std::size_t& diagonal, limb* result, Workspace& ws) {
+			const std::size_t RESULT_LEN = diagonal + 3;
+			// limbs past the diagonal don't contribute
+			if (a_len > diagonal + 1) { a_len = diagonal + 1; }
+			if (b_len > diagonal + 1) { b_len = diagonal + 1; }
+			helpers::set_to_zero(result, RESULT_LEN);
+			if (a_len == 0 || b_len == 0) { return; }
+			const std::size_t SHORTER = a_len < b_len ? a_len : b_len;
+			if (SHORTER < karatsuba_threshold) {
+				double_limb carry, tmp;
+				std::size_t i = a_len, j;
+				while (i > 0) {
+					--i;
+					carry = 0;
+					j = diagonal - i < b_len - 1 ? diagonal - i + 1 : b_len;
+					while (j > 0) {
+						--j;
+						tmp = carry + result[i + j + 2] + static_cast<double_limb>(a[i]) * b[j];
+						result[i + j + 2] = static_cast<limb>(tmp);
+						carry = tmp >> LIMB_BITS;
+					}
+					// rows with a higher i only reach index i + 2
+					result[i + 1] = static_cast<limb>(carry);
+				}
+				return;
+			}
+			Workspace::Frame frame(ws);
+			// a split at 7 / 10 of the diagonal balances the full product against the triangles
+			std::size_t k = diagonal * 7 / 10 + 1;
+			if (k <= diagonal / 2) { k = diagonal / 2 + 1; }
+			const std::size_t A_HIGH = a_len < k ? a_len : k;
+			const std::size_t B_HIGH = b_len < k ? b_len : k;
+			limb* block = ws.allocate(A_HIGH + B_HIGH + 1);
+			multiply_into(a, A_HIGH, b, B_HIGH, block, A_HIGH + B_HIGH + 1, ws);
+			add_at(result, RESULT_LEN, block, A_HIGH + B_HIGH + 1, 0);
+			if (a_len <= k && b_len <= k) { return; }
+			limb* triangle = ws.allocate(diagonal - k + 3);
+			if (a_len > k) {
+				high_product(a + k, a_len - k, b, b_len, diagonal - k, triangle, ws);
+				add_at(result, RESULT_LEN, triangle, diagonal - k + 3, k);
+			}
+			if (b_len > k) {
+				high_product(a, a_len, b + k, b_len - k, diagonal - k, triangle, ws);
+				add_at(result, RESULT_LEN, triangle, diagonal - k + 3, k);
+			}
+		}
+		/**
+		 * complete homogeneous symmetric polynomial of the given degree in 1, 2, ..., n
+		 */
+		double_limb homogeneous(const std::size_t& degree, const std::size_t& n) {
+			if (degree == 0) { return 1; }
+			if (n == 0) { return 0; }
+			return homogeneous(degree, n - 1) + n * homogeneous(degree - 1, n);
+		}
+		/**
+		 * Toom-Cook multiplication
+		 * a and b are split into pieces of k = ceil(a_len / parts) limbs, which are the
+		 * coefficients of polynomials a(x) and b(x) with a(RADIX^k) = a. The product
+		 * polynomial c(x) = a(x) * b(x) of degree 2 * parts - 2 is found from its values
+		 * at 0, 1, 2, ..., 2 * parts - 3 and infinity (the product of the leading
+		 * coefficients), and c(RADIX^k) is a * b.
+		 * Using only non-negative points keeps all intermediate values non-negative:
+		 * with c_0 and c_top known, r(x) = (c(x) - c_0 - c_top * x^(2 * parts - 2)) / x
+		 * has non-negative coefficients c_1, c_2, ... The divided differences of r at
+		 * 1, 2, ... are then non-negative as well, and each coefficient of r is its divided
+		 * difference minus non-negative multiples of the higher coefficients
+		 * If a and b are the same array, a(x) is evaluated only once and the
+		 * sub-products are squares
+		 * The 2 * parts - 1 sub-products are independent SubProducts
+		 * Assumptions:
+		 * 1) result has length a_len + b_len + 1
+		 * 2) a_len / 2 < b_len <= a_len
+		 */
+		void toom_multiply(const limb* a, const limb* b, limb* result, const std::size_t& a_len,
+				const std::size_t& b_len, const std::size_t& parts, Workspace& ws) {
+			const std::size_t RESULT_LEN = a_len + b_len + 1;
+			const std::size_t K = (a_len + parts - 1) / parts;
+			const std::size_t TOP = 2 * parts - 2;
+			// r is evaluated at 1, 2, ..., POINTS
+			const std::size_t POINTS = TOP - 1;
+			// values at x <= POINTS are less than RADIX^(K + 1)
+			const std::size_t EVAL_LEN = K + 1;
+			const std::size_t VALUE_LEN = 2 * EVAL_LEN + 1;
+			const bool SQUARING = a == b && a_len == b_len;
+			Workspace::Frame frame(ws);
+			// the values of a(x) and b(x) at all points, so that the products can run concurrently
+			limb* a_values = ws.allocate(POINTS * EVAL_LEN);
+			limb* b_values = SQUARING ? a_values : ws.allocate(POINTS * EVAL_LEN);
+			limb* c_0 = ws.allocate(VALUE_LEN);
+			limb* c_top = ws.allocate(VALUE_LEN);
+			limb* r = ws.allocate(POINTS * VALUE_LEN);
+			const limb* piece_a;
+			const limb* piece_b;
+			std::size_t piece_a_len, piece_b_len, i, j;
+			for (limb x = 1; x <= POINTS; ++x) {
+				limb* a_value = a_values + (x - 1) * EVAL_LEN;
+				limb* b_value = b_values + (x - 1) * EVAL_LEN;
+				// Horner's rule
+				helpers::set_to_zero(a_value, EVAL_LEN);
+				if (!SQUARING) { helpers::set_to_zero(b_value, EVAL_LEN); }
+				for (i = parts; i > 0; ) {
+					--i;
+					multiply_by_limb(a_value, EVAL_LEN, x);
+					get_piece(a, a_len, K, i, piece_a, piece_a_len);
+					add_into(a_value, EVAL_LEN, piece_a, piece_a_len, 0);
+					if (SQUARING) { continue; }
+					multiply_by_limb(b_value, EVAL_LEN, x);
+					get_piece(b, b_len, K, i, piece_b, piece_b_len);
+					add_into(b_value, EVAL_LEN, piece_b, piece_b_len, 0);
+				}
+			}
+			SubProducts products(b_len, ws);
+			get_piece(a, a_len, K, 0, piece_a, piece_a_len);
+			get_piece(b, b_len, K, 0, piece_b, piece_b_len);
+			products.run([=](Workspace& task_ws) {
+				multiply_into(piece_a, piece_a_len, piece_b, piece_b_len, c_0, VALUE_LEN, task_ws);
+			});
+			get_piece(a, a_len, K, parts - 1, piece_a, piece_a_len);
+			get_piece(b, b_len, K, parts - 1, piece_b, piece_b_len);
+			products.run([=](Workspace& task_ws) {
+				multiply_into(piece_a, piece_a_len, piece_b, piece_b_len, c_top, VALUE_LEN, task_ws);
+			});
+			for (i = 0; i < POINTS; ++i) {
+				products.run([=](Workspace& task_ws) {
+					multiply_into(a_values + i * EVAL_LEN, EVAL_LEN, b_values + i * EVAL_LEN, EVAL_LEN,
+							r + i * VALUE_LEN, VALUE_LEN, task_ws);
+				});
+			}
+			products.wait();
+			for (limb x = 1; x <= POINTS; ++x) {
+				limb* r_x = r + (x - 1) * VALUE_LEN;
+				limb x_to_top = 1;
+				for (i = 0; i < TOP; ++i) { x_to_top *= x; }
+				subtract_from(r_x, VALUE_LEN, c_0, VALUE_LEN);
+				subtract_multiple(r_x, VALUE_LEN, c_top, VALUE_LEN, x_to_top);
+				divide_exact_by_limb(r_x, VALUE_LEN, x);
+			}
+			// divided differences: the points with indices i and i - j differ by j
+			for (j = 1; j < POINTS; ++j) {
+				for (i = POINTS - 1; i >= j; --i) {
+					subtract_from(r + i * VALUE_LEN, VALUE_LEN, r + (i - 1) * VALUE_LEN, VALUE_LEN);
+					if (j > 1) { divide_exact_by_limb(r + i * VALUE_LEN, VALUE_LEN, static_cast<limb>(j)); }
+				}
+			}
+			// the divided difference with index d is the sum over m >= d of
+			// coefficient m of r times homogeneous(m - d, d + 1)
+			for (i = POINTS; i > 0; ) {
+				--i;
+				for (j = i + 1; j < POINTS; ++j) {
+					subtract_multiple(r + i * VALUE_LEN, VALUE_LEN, r + j * VALUE_LEN, VALUE_LEN,
+							static_cast<limb>(homogeneous(j - i, i + 1)));
+				}
+			}
+			// coefficient i of r is c_(i + 1)
+			helpers::set_to_zero(result, RESULT_LEN);
+			add_into(result, RESULT_LEN, c_0, VALUE_LEN, 0);
+			for (i = 0; i < POINTS; ++i) { add_into(result, RESULT_LEN, r + i * VALUE_LEN, VALUE_LEN, (i + 1) * K); }
+			add_into(result, RESULT_LEN, c_top, VALUE_LEN, TOP * K);
+		}
+		/**
+		 * base^exponent modulo modulus
+		 */
+		limb power_modulo(limb base, double_limb exponent, const limb& modulus) {
+			double_limb result = 1, square = base % modulus;
+			while (exponent > 0) {
+				if (exponent & 1) { result = result * square % modulus; }
+				square = square * square % modulus;
+				exponent >>= 1;
+			}
+			return static_cast<limb>(result);
+		}
+		/**
+		 * In-place number theoretic transform of length n (a power of 2) modulo
+		 * the prime MODULUS, for which GENERATOR is a primitive root
+		 * The inverse transform includes the division by n
+		 * roots is scratch memory for n / 2 limbs
+		 * MODULUS is a template parameter so that the compiler can replace the
+		 * remainder operations by multiplications
+		 */
+		template <limb MODULUS, limb GENERATOR>
+		void number_theoretic_transform(limb* x, const std::size_t& n, const bool& inverse, limb* roots) {
+			std::size_t i, j, k;
+			// bit reversal permutation
+			for (i = 1, j = 0; i < n; ++i) {
+				std::size_t bit = n >> 1;
+				for ( ; j & bit; bit >>= 1) { j ^= bit; }
+				j ^= bit;
+				if (i < j) {
+					limb tmp = x[i];
+					x[i] = x[j];
+					x[j] = tmp;
+				}
+			}
+			for (std::size_t len = 2; len <= n; len <<= 1) {
+				const std::size_t HALF = len / 2;
+				limb root = power_modulo(GENERATOR, (MODULUS - 1) / len, MODULUS);
+				if (inverse) { root = power_modulo(root, MODULUS - 2, MODULUS); }
+				roots[0] = 1;
+				for (k = 1; k < HALF; ++k) {
+					roots[k] = static_cast<limb>(static_cast<double_limb>(roots[k - 1]) * root % MODULUS);
+				}
+				for (i = 0; i < n; i += len) {
+					for (k = 0; k < HALF; ++k) {
+						limb u = x[i + k];
+						limb v = static_cast<limb>(static_cast<double_limb>(x[i + k + HALF]) * roots[k] % MODULUS);
+						x[i + k] = u + v >= MODULUS ? u + v - MODULUS : u + v;
+						x[i + k + HALF] = u >= v ? u - v : u + MODULUS - v;
+					}
+				}
+			}
+			if (inverse) {
+				const double_limb N_INVERSE = power_modulo(static_cast<limb>(n % MODULUS), MODULUS - 2, MODULUS);
+				for (i = 0; i < n; ++i) { x[i] = static_cast<limb>(x[i] * N_INVERSE % MODULUS); }
+			}
+		}
+		/**
+		 * sets residues to the cyclic convolution of length n of the limbs of a and b,
+		 * least significant first, modulo MODULUS. scratch must have room for
+		 * 2 * n limbs. If concurrent is set, the forward transforms of a and b
+		 * run concurrently
+		 */
+		template <limb MODULUS, limb GENERATOR>
+		void convolution(const limb* a, const std::size_t& a_len, const limb* b, const std::size_t& b_len,
+				limb* residues, const std::size_t& n, limb* scratch, const bool& concurrent) {
+			limb* b_transform = scratch;
+			limb* roots = scratch + n;
+			limb* b_roots = roots + n / 2;
+			std::size_t i;
+			// a square needs only 1 forward transform
+			const bool SQUARING = a == b && a_len == b_len;
+			for (i = 0; i < n; ++i) {
+				residues[i] = i < a_len ? a[a_len - 1 - i] % MODULUS : 0;
+				if (!SQUARING) { b_transform[i] = i < b_len ? b[b_len - 1 - i] % MODULUS : 0; }
+			}
+			TaskGroup transforms;
+			if (SQUARING) { b_transform = residues; }
+			else if (concurrent) {
+				transforms.run([=] { number_theoretic_transform<MODULUS, GENERATOR>(b_transform, n, false, b_roots); });
+			}
+			else { number_theoretic_transform<MODULUS, GENERATOR>(b_transform, n, false, b_roots); }
+			number_theoretic_transform<MODULUS, GENERATOR>(residues, n, false, roots);
+			transforms.wait();
+			for (i = 0; i < n; ++i) {
+				residues[i] = static_cast<limb>(static_cast<double_limb>(residues[i]) * b_transform[i] % MODULUS);
+			}
+			number_theoretic_transform<MODULUS, GENERATOR>(residues, n, true, roots);
+		}
+		/**
+		 * primes of the form c * 2^k + 1 with primitive root 3, allowing transforms
+		 * of length up to 2^23. The product of the 3 primes exceeds 2^86, so it bounds
+		 * every coefficient of the convolution for products of up to NTT_MAX_LEN limbs
+		 */
+		const limb NTT_PRIME_1 = 998244353;
+		const limb NTT_PRIME_2 = 167772161;
+		const limb NTT_PRIME_3 = 469762049;
+		const limb NTT_GENERATOR = 3;
+		/**
+		 * writes source shifted left by the given number of bits (< LIMB_BITS)
+		 * into the rightmost positions of result, where result_len >= source_len
+		 * If result_len == source_len, the bits shifted out must be 0
+		 */
+		void shift_left_bits(const limb* source, const std::size_t& source_len, limb* result,
+				const std::size_t& result_len, const std::size_t& bits) {
+			const std::size_t OFFSET = result_len - source_len;
+			limb carry = 0;
+			std::size_t i = source_len;
+			while (i > 0) {
+				--i;
+				limb tmp = source[i];
+				result[i + OFFSET] = bits == 0 ? tmp : (tmp << bits) | carry;
+				carry = bits == 0 ? 0 : tmp >> (LIMB_BITS - bits);
+			}
+			i = OFFSET;
+			while (i > 0) {
+				--i;
+				result[i] = carry;
+				carry = 0;
+			}
+		}
+		/**
+		 * Newton-Raphson approximation of a reciprocal
+		 * d has length d_len and represents the fraction d / RADIX^d_len, which must be
+		 * at least 1/2 (the top bit of d[0] is set)
+		 * result gets precision + 1 limbs representing x / RADIX^precision, so result[0]
+		 * is the integer part. x satisfies 1/d - 16 / RADIX^precision < x <= 1/d
+		 *
+		 * x is an approximation x_h to about half the precision improved by 1 Newton step,
+		 * x = x_h + x_h * (1 - d * x_h). d is rounded up to the new precision, so that
+		 * every approximation stays below 1/d and 1 - d * x_h can't become negative
+		 */
+		void reciprocal(const limb* d, const std::size_t& d_len, limb* result,
+				const std::size_t& precision, Workspace& ws) {
+			if (precision == 1) {
+				double_limb top = d[0];
+				if (d_len > 1) { ++top; }
+				double_limb x = top == RADIX ? RADIX : ~static_cast<double_limb>(0) / top;
+				result[0] = static_cast<limb>(x >> LIMB_BITS);
+				result[1] = static_cast<limb>(x);
+				return;
+			}
+			// at least 1 more than half the precision keeps the squared error small
+			const std::size_t HALF = precision == 2 ? 1 : precision / 2 + 1;
+			const limb ONE = 1;
+			Workspace::Frame frame(ws);
+			limb* x_h = ws.allocate(HALF + 1);
+			limb* d_up = ws.allocate(precision + 1);
+			limb* product = ws.allocate(precision + HALF + 3);
+			reciprocal(d, d_len, x_h, HALF, ws);
+			// d rounded up to precision limbs, with an integer limb in case it rounds up to 1
+			d_up[0] = 0;
+			helpers::copy_into(d, d_up + 1, d_len < precision ? d_len : precision, precision);
+			if (d_len > precision) { add_into(d_up, precision + 1, &ONE, 1, 0); }
+			const limb* d_trimmed = d_up;
+			std::size_t d_trimmed_len = precision + 1;
+			trim(d_trimmed, d_trimmed_len);
+			// d * x_h <= 1 has precision + HALF fractional limbs
+			const std::size_t PRODUCT_LEN = d_trimmed_len + HALF + 2;
+			multiply_any(d_trimmed, x_h, product, d_trimmed_len, HALF + 1, ws);
+			helpers::copy_into(x_h, result, HALF + 1, precision + 1);
+			// d * x_h == 1 needs no correction
+			if (!helpers::is_zero(product, PRODUCT_LEN - precision - HALF)) { return; }
+			// 1 - d * x_h is the two's complement of the fractional limbs
+			limb* error = product + PRODUCT_LEN - precision - HALF;
+			for (std::size_t i = 0; i < precision + HALF; ++i) { error[i] = ~error[i]; }
+			add_into(error, precision + HALF, &ONE, 1, 0);
+			// truncated to precision limbs
+			const limb* error_trimmed = error;
+			std::size_t error_len = precision;
+			trim(error_trimmed, error_len);
+			// x_h * (1 - d * x_h) with the last HALF limbs dropped
+			limb* correction = ws.allocate(HALF + error_len + 2);
+			multiply_any(x_h, error_trimmed, correction, HALF + 1, error_len, ws);
+			add_into(result, precision + 1, correction, error_len + 2, 0);
+		}
+		/**
+		 * decimal digits are produced in chunks of DECIMAL_CHUNK_DIGITS, where
+		 * DECIMAL_CHUNK = 10^DECIMAL_CHUNK_DIGITS is the largest power of 10 in a limb
+		 */
+		const std::size_t DECIMAL_CHUNK_DIGITS = 9;
+		const limb DECIMAL_CHUNK = 1000000000;
+		/**
+		 * arrays up to this length are converted to decimal one chunk at a time
+		 */
+		const std::size_t DECIMAL_BASE_LEN = 32;
+		/**
+		 * enough levels of powers of 10 for numbers with 2^64 limbs
+		 */
+		const std::size_t MAX_DECIMAL_LEVELS = 64;
+		/**
+		 * sets powers[i] to 10^(DECIMAL_CHUNK_DIGITS * 2^i), with length power_lens[i],
+		 * computed by repeated squaring for all such powers with fewer than digits digits
+		 * The powers are allocated from ws
+		 */
+		void decimal_powers(const std::size_t& digits, const limb** powers, std::size_t* power_lens,
+				Workspace& ws) {
+			limb* first = ws.allocate(1);
+			first[0] = DECIMAL_CHUNK;
+			powers[0] = first;
+			power_lens[0] = 1;
+			for (std::size_t level = 1; (DECIMAL_CHUNK_DIGITS << level) < digits; ++level) {
+				const std::size_t PREVIOUS_LEN = power_lens[level - 1];
+				limb* square = ws.allocate(2 * PREVIOUS_LEN + 1);
+				multiply(powers[level - 1], powers[level - 1], square, PREVIOUS_LEN, PREVIOUS_LEN, ws);
+				powers[level] = square;
+				power_lens[level] = 2 * PREVIOUS_LEN + 1;
+				trim(powers[level], power_lens[level]);
+			}
+		}
+		/**
+		 * Sets result to the integer with the given decimal digits, right-aligned
+		 * in result_len >= convert::power_of_ten_len(digits_len) limbs
+		 * powers are as in decimal_powers(). The value of the digits is
+		 * high * 10^(DECIMAL_CHUNK_DIGITS * 2^i) + low with the largest such power
+		 * that has fewer digits, and high and low are computed recursively
+		 */
+		void decimal_value(const char* digits, const std::size_t& digits_len, limb* result,
+				const std::size_t& result_len, const limb* const* powers, const std::size_t* power_lens,
+				Workspace& ws) {
+			helpers::set_to_zero(result, result_len);
+			if (digits_len <= DECIMAL_BASE_LEN * DECIMAL_CHUNK_DIGITS) {
+				// Horner's rule, a chunk of digits at a time
+				std::size_t i = 0, chunk_len = digits_len % DECIMAL_CHUNK_DIGITS;
+				if (chunk_len == 0) { chunk_len = DECIMAL_CHUNK_DIGITS; }
+				while (i < digits_len) {
+					double_limb chunk = 0, factor = 1, carry, tmp;
+					for (std::size_t end = i + chunk_len; i < end; ++i) {
+						if (digits[i] < '0' || '9' < digits[i]) {
+							throw std::invalid_argument("Input can contain only decimal digits!");
+						}
+						chunk = 10 * chunk + (digits[i] - '0');
+						factor *= 10;
+					}
+					carry = chunk;
+					std::size_t j = result_len;
+					while (j > 0) {
+						--j;
+						tmp = carry + result[j] * factor;
+						result[j] = static_cast<limb>(tmp);
+						carry = tmp >> LIMB_BITS;
+					}
+					chunk_len = DECIMAL_CHUNK_DIGITS;
+				}
+				return;
+			}
+			std::size_t level = 0;
+			while ((DECIMAL_CHUNK_DIGITS << (level + 1)) < digits_len) { ++level; }
+			const std::size_t LOW_DIGITS = DECIMAL_CHUNK_DIGITS << level;
+			const std::size_t HIGH_DIGITS = digits_len - LOW_DIGITS;
+			const limb* power = powers[level];
+			const std::size_t POWER_LEN = power_lens[level];
+			const std::size_t HIGH_LEN = convert::power_of_ten_len(HIGH_DIGITS);
+			const std::size_t PRODUCT_LEN = HIGH_LEN + POWER_LEN + 1;
+			Workspace::Frame frame(ws);
+			limb* high = ws.allocate(HIGH_LEN);
+			limb* low = ws.allocate(POWER_LEN);
+			limb* product = ws.allocate(PRODUCT_LEN);
+			decimal_value(digits, HIGH_DIGITS, high, HIGH_LEN, powers, power_lens, ws);
+			decimal_value(digits + HIGH_DIGITS, LOW_DIGITS, low, POWER_LEN, powers, power_lens, ws);
+			const limb* high_trimmed = high;
+			std::size_t high_trimmed_len = HIGH_LEN;
+			trim(high_trimmed, high_trimmed_len);
+			multiply_any(high_trimmed, power, product, high_trimmed_len, POWER_LEN, ws);
+			add_into(product, high_trimmed_len + POWER_LEN + 1, low, POWER_LEN, 0);
+			// the value has fewer than result_len limbs
+			const std::size_t VALUE_LEN = high_trimmed_len + POWER_LEN + 1;
+			if (VALUE_LEN > result_len) {
+				helpers::copy_into(product + VALUE_LEN - result_len, result, result_len, result_len);
+			}
+			else { helpers::copy_into(product, result + result_len - VALUE_LEN, VALUE_LEN, VALUE_LEN); }
+		}
+		/**
+		 * Writes the digits characters of num < 10^digits into result
+		 * powers[i] is 10^(DECIMAL_CHUNK_DIGITS * 2^i) with length power_lens[i]
+		 * num is split into quotient and remainder by the largest of these powers
+		 * with fewer digits than num, and both halves are converted recursively
+		 */
+		void decimal_digits(const limb* num, std::size_t num_len, char* result, const std::size_t& digits,
+				const limb* const* powers, const std::size_t* power_lens, Workspace& ws) {
+			trim(num, num_len);
+			Workspace::Frame frame(ws);
+			if (num_len <= DECIMAL_BASE_LEN) {
+				limb* tmp = ws.allocate(num_len);
+				helpers::copy_into(num, tmp, num_len, num_len);
+				std::size_t pos = digits;
+				while (pos > 0) {
+					limb chunk = divide_by_limb(tmp, num_len, DECIMAL_CHUNK);
+					for (std::size_t i = 0; i < DECIMAL_CHUNK_DIGITS && pos > 0; ++i) {
+						result[--pos] = static_cast<char>('0' + chunk % 10);
+						chunk /= 10;
+					}
+				}
+				return;
+			}
+			std::size_t level = 0;
+			while ((DECIMAL_CHUNK_DIGITS << (level + 1)) < digits) { ++level; }
+			const std::size_t LOW_DIGITS = DECIMAL_CHUNK_DIGITS << level;
+			const limb* power = powers[level];
+			const std::size_t POWER_LEN = power_lens[level];
+			if (POWER_LEN > num_len) {
+				// num < power, so all high digits are 0
+				for (std::size_t i = 0; i < digits - LOW_DIGITS; ++i) { result[i] = '0'; }
+				decimal_digits(num, num_len, result + digits - LOW_DIGITS, LOW_DIGITS, powers, power_lens, ws);
+				return;
+			}
+			limb* divisor = ws.allocate(num_len);
+			limb* quotient = ws.allocate(num_len);
+			limb* product = ws.allocate(2 * num_len + 1);
+			limb* remainder = ws.allocate(num_len);
+			helpers::set_to_zero(divisor, num_len - POWER_LEN);
+			helpers::copy_into(power, divisor + num_len - POWER_LEN, POWER_LEN, POWER_LEN);
+			// integer division, so all limbs are integer places
+			if (num_len >= newton_division_threshold) { newton_divide(num, divisor, quotient, num_len, num_len, ws); }
+			else { divide(num, divisor, quotient, num_len, num_len, ws); }
+			const limb* q = quotient;
+			std::size_t q_len = num_len;
+			trim(q, q_len);
+			multiply_any(q, power, product, q_len, POWER_LEN, ws);
+			// quotient * power <= num, so the product has at most num_len significant limbs
+			const std::size_t PRODUCT_LEN = q_len + POWER_LEN + 1;
+			helpers::copy_into(num, remainder, num_len, num_len);
+			if (PRODUCT_LEN > num_len) { subtract_from(remainder, num_len, product + PRODUCT_LEN - num_len, num_len); }
+			else { subtract_from(remainder, num_len, product, PRODUCT_LEN); }
+			decimal_digits(quotient, num_len, result, digits - LOW_DIGITS, powers, power_lens, ws);
+			decimal_digits(remainder, num_len, result + digits - LOW_DIGITS, LOW_DIGITS, powers, power_lens, ws);
+		}
+	}
+	SimdLevel supported_simd_level() {
+#ifdef ARRAY_ARITHMETIC_X86_SIMD
+		// needed when called before the constructors of the runtime library have run
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) { return SIMD_AVX2; }
+		if (__builtin_cpu_supports("sse4.2")) { return SIMD_SSE42; }
+#endif
+		return SIMD_SCALAR;
+	}
+
+	SimdLevel simd_level = supported_simd_level();
+
+	/**
+	 * Kernels for add(), subtract() and the comparisons
+	 * add and subtract work on arrays of the same length, take the carry (or borrow)
+	 * into the last limb and return the carry (or borrow) out of the first one.
+	 * result may be a or b.
+	 * The vector versions use carry lookahead: each lane computes its sum together
+	 * with whether it generates a carry (the sum wrapped around) or propagates one
+	 * (the sum is RADIX - 1). The carries of all lanes are then resolved at once
+	 * by adding the bit masks of the lanes, ordered from least significant, as
+	 * integers: (generate << 1) + propagate + carry_in flips exactly the bits of the
+	 * lanes that propagate an incoming carry, and its bit past the last lane is
+	 * the carry out of the block
+	 */
+	namespace {
+		limb scalar_add(const limb* a, const limb* b, limb* result, std::size_t len, limb carry) {
+			double_limb tmp_sum;
+			while (len > 0) {
+				--len;
+				tmp_sum = static_cast<double_limb>(carry) + a[len] + b[len];
+				result[len] = static_cast<limb>(tmp_sum);
+				carry = static_cast<limb>(tmp_sum >> LIMB_BITS);
+			}
+			return carry;
+		}
+		limb scalar_subtract(const limb* a, const limb* b, limb* result, std::size_t len, limb borrow) {
+			double_limb tmp_diff;
+			while (len > 0) {
+				--len;
+				// wraps around if b[len] + borrow > a[len], which sets all high bits
+				tmp_diff = static_cast<double_limb>(a[len]) - b[len] - borrow;
+				result[len] = static_cast<limb>(tmp_diff);
+				borrow = static_cast<limb>(tmp_diff >> LIMB_BITS) & 1;
+			}
+			return borrow;
+		}
+		// index of the first limb where a and b differ, len if they are equal
+		std::size_t scalar_first_difference(const limb* a, const limb* b, const std::size_t& len) {
+			std::size_t i = 0;
+			while (i < len && a[i] == b[i]) { ++i; }
+			return i;
+		}
+		bool scalar_is_zero(const limb* arr, const std::size_t& len) {
+			for (std::size_t i = 0; i < len; ++i) {
+				if (arr[i] != 0) { return false; }
+			}
+			return true;
+		}
+
+#ifdef ARRAY_ARITHMETIC_X86_SIMD
+		const int SIGN_BIT = -0x7fffffff - 1;
+
+		/**
+		 * SSE4.2: 4 limbs per block. Reversing the lanes before taking the bit
+		 * masks puts the least significant limb at bit 0
+		 */
+		__attribute__((target("sse4.2")))
+		limb sse42_add(const limb* a, const limb* b, limb* result, std::size_t len, limb carry) {
+			const __m128i SIGN = _mm_set1_epi32(SIGN_BIT);
+			const __m128i ONES = _mm_set1_epi32(-1);
+			// lane k receives a carry if bit 3 - k is set
+			const __m128i LANE_BITS = _mm_set_epi32(1, 2, 4, 8);
+			while (len >= 4) {
+				len -= 4;
+				__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + len));
+				__m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + len));
+				__m128i sum = _mm_add_epi32(x, y);
+				// unsigned sum < x
+				__m128i generate = _mm_cmpgt_epi32(_mm_xor_si128(x, SIGN), _mm_xor_si128(sum, SIGN));
+				__m128i propagate = _mm_cmpeq_epi32(sum, ONES);
+				unsigned g = _mm_movemask_ps(_mm_castsi128_ps(_mm_shuffle_epi32(generate, 0x1b)));
+				unsigned p = _mm_movemask_ps(_mm_castsi128_ps(_mm_shuffle_epi32(propagate, 0x1b)));
+				unsigned carries = (g << 1) + p + carry;
+				__m128i incoming = _mm_set1_epi32(static_cast<int>((carries ^ p) & 0xf));
+				incoming = _mm_cmpeq_epi32(_mm_and_si128(incoming, LANE_BITS), LANE_BITS);
+				// incoming lanes are -1
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(result + len), _mm_sub_epi32(sum, incoming));
+				carry = carries >> 4;
+			}
+			return scalar_add(a, b, result, len, carry);
+		}
+		__attribute__((target("sse4.2")))
+		limb sse42_subtract(const limb* a, const limb* b, limb* result, std::size_t len, limb borrow) {
+			const __m128i SIGN = _mm_set1_epi32(SIGN_BIT);
+			const __m128i ZERO = _mm_setzero_si128();
+			const __m128i LANE_BITS = _mm_set_epi32(1, 2, 4, 8);
+			while (len >= 4) {
+				len -= 4;
+				__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + len));
+				__m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + len));
+				__m128i diff = _mm_sub_epi32(x, y);
+				// unsigned y > x
+				__m128i generate = _mm_cmpgt_epi32(_mm_xor_si128(y, SIGN), _mm_xor_si128(x, SIGN));
+				__m128i propagate = _mm_cmpeq_epi32(diff, ZERO);
+				unsigned g = _mm_movemask_ps(_mm_castsi128_ps(_mm_shuffle_epi32(generate, 0x1b)));
+				unsigned p = _mm_movemask_ps(_mm_castsi128_ps(_mm_shuffle_epi32(propagate, 0x1b)));
+				unsigned borrows = (g << 1) + p + borrow;
+				__m128i incoming = _mm_set1_epi32(static_cast<int>((borrows ^ p) & 0xf));
+				incoming = _mm_cmpeq_epi32(_mm_and_si128(incoming, LANE_BITS), LANE_BITS);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(result + len), _mm_add_epi32(diff, incoming));
+				borrow = borrows >> 4;
+			}
+			return scalar_subtract(a, b, result, len, borrow);
+		}
+		__attribute__((target("sse4.2")))
+		std::size_t sse42_first_difference(const limb* a, const limb* b, const std::size_t& len) {
+			std::size_t i = 0;
+			for ( ; i + 4 <= len; i += 4) {
+				__m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+						_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+				unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+				if (mask != 0xf) { return i + __builtin_ctz(~mask); }
+			}
+			return i + scalar_first_difference(a + i, b + i, len - i);
+		}
+		__attribute__((target("sse4.2")))
+		bool sse42_is_zero(const limb* arr, const std::size_t& len) {
+			std::size_t i = 0;
+			for ( ; i + 4 <= len; i += 4) {
+				__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(arr + i));
+				if (!_mm_testz_si128(x, x)) { return false; }
+			}
+			return scalar_is_zero(arr + i, len - i);
+		}
+
+		/**
+		 * AVX2: 8 limbs per block
+		 */
+		__attribute__((target("avx2")))
+		limb avx2_add(const limb* a, const limb* b, limb* result, std::size_t len, limb carry) {
+			const __m256i SIGN = _mm256_set1_epi32(SIGN_BIT);
+			const __m256i ONES = _mm256_set1_epi32(-1);
+			const __m256i REVERSE = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+			// lane k receives a carry if bit 7 - k is set
+			const __m256i LANE_BITS = _mm256_set_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+			while (len >= 8) {
+				len -= 8;
+				__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + len));
+				__m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + len));
+				__m256i sum = _mm256_add_epi32(x, y);
+				__m256i generate = _mm256_cmpgt_epi32(_mm256_xor_si256(x, SIGN), _mm256_xor_si256(sum, SIGN));
+				__m256i propagate = _mm256_cmpeq_epi32(sum, ONES);
+				unsigned g = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_permutevar8x32_epi32(generate, REVERSE)));
+				unsigned p = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_permutevar8x32_epi32(propagate, REVERSE)));
+				unsigned carries = (g << 1) + p + carry;
+				__m256i incoming = _mm256_set1_epi32(static_cast<int>((carries ^ p) & 0xff));
+				incoming = _mm256_cmpeq_epi32(_mm256_and_si256(incoming, LANE_BITS), LANE_BITS);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(result + len), _mm256_sub_epi32(sum, incoming));
+				carry = carries >> 8;
+			}
+			return scalar_add(a, b, result, len, carry);
+		}
+		__attribute__((target("avx2")))
+		limb avx2_subtract(const limb* a, const limb* b, limb* result, std::size_t len, limb borrow) {
+			const __m256i SIGN = _mm256_set1_epi32(SIGN_BIT);
+			const __m256i ZERO = _mm256_setzero_si256();
+			const __m256i REVERSE = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+			const __m256i LANE_BITS = _mm256_set_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+			while (len >= 8) {
+				len -= 8;
+				__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + len));
+				__m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + len));
+				__m256i diff = _mm256_sub_epi32(x, y);
+				__m256i generate = _mm256_cmpgt_epi32(_mm256_xor_si256(y, SIGN), _mm256_xor_si256(x, SIGN));
+				__m256i propagate = _mm256_cmpeq_epi32(diff, ZERO);
+				unsigned g = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_permutevar8x32_epi32(generate, REVERSE)));
+				unsigned p = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_permutevar8x32_epi32(propagate, REVERSE)));
+				unsigned borrows = (g << 1) + p + borrow;
+				__m256i incoming = _mm256_set1_epi32(static_cast<int>((borrows ^ p) & 0xff));
+				incoming = _mm256_cmpeq_epi32(_mm256_and_si256(incoming, LANE_BITS), LANE_BITS);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(result + len), _mm256_add_epi32(diff, incoming));
+				borrow = borrows >> 8;
+			}
+			return scalar_subtract(a, b, result, len, borrow);
+		}
+		__attribute__((target("avx2")))
+		std::size_t avx2_first_difference(const limb* a, const limb* b, const std::size_t& len) {
+			std::size_t i = 0;
+			for ( ; i + 8 <= len; i += 8) {
+				__m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+						_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+				unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+				if (mask != 0xff) { return i + __builtin_ctz(~mask); }
+			}
+			return i + scalar_first_difference(a + i, b + i, len - i);
+		}
+		__attribute__((target("avx2")))
+		bool avx2_is_zero(const limb* arr, const std::size_t& len) {
+			std::size_t i = 0;
+			for ( ; i + 8 <= len; i += 8) {
+				__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(arr + i));
+				if (!_mm256_testz_si256(x, x)) { return false; }
+			}
+			return scalar_is_zero(arr + i, len - i);
+		}
+#endif
+
+		limb add_with_carry(const limb* a, const limb* b, limb* result, const std::size_t& len, limb carry) {
+#ifdef ARRAY_ARITHMETIC_X86_SIMD
+			if (simd_level == SIMD_AVX2) { return avx2_add(a, b, result, len, carry); }
+			if (simd_level == SIMD_SSE42) { return sse42_add(a, b, result, len, carry); }
+#endif
+			return scalar_add(a, b, result, len, carry);
+		}
+		limb subtract_with_borrow(const limb* a, const limb* b, limb* result, const std::size_t& len,
+				limb borrow) {
+#ifdef ARRAY_ARITHMETIC_X86_SIMD
+			if (simd_level == SIMD_AVX2) { return avx2_subtract(a, b, result, len, borrow); }
+			if (simd_level == SIMD_SSE42) { return sse42_subtract(a, b, result, len, borrow); }
+#endif
+			return scalar_subtract(a, b, result, len, borrow);
+		}
+		std::size_t first_difference(const limb* a, const limb* b, const std::size_t& len) {
+#ifdef ARRAY_ARITHMETIC_X86_SIMD
+			if (simd_level == SIMD_AVX2) { return avx2_first_difference(a, b, len); }
+			if (simd_level == SIMD_SSE42) { return sse42_first_difference(a, b, len); }
+#endif
+			return scalar_first_difference(a, b, len);
+		}
 	}
 	/**
 	 * conversion functions
 	 */
 	namespace convert {
-		void from_int(const unsigned int& num, unsigned char* result, 
+		void from_int(const unsigned int& num, limb* result, 
 				const std::size_t& result_len) {
-			unsigned int num_copy = num;
+			double_limb num_copy = num;
 			std::size_t i = result_len;
 			while (i > 0) {
 				--i;
-				result[i] = num_copy % RADIX;
-				num_copy /= RADIX;
+				result[i] = static_cast<limb>(num_copy);
+				num_copy >>= LIMB_BITS;
 			}
 		}
-		unsigned int to_int(const unsigned char* arr, const std::size_t& arr_len) {
-			unsigned int result = 0;
+		unsigned int to_int(const limb* arr, const std::size_t& arr_len) {
+			double_limb result = 0;
 			for (std::size_t i = 0; i < arr_len; ++i) {
-				result = result * RADIX + arr[i];
+				result = (result << LIMB_BITS) + arr[i];
 			}
-			return result;
+			return static_cast<unsigned int>(result);
 		}
 		namespace helpers {
 			unsigned char* to_digit_array(const std::string& str) {
+				unsigned char* result = new unsigned char[str.size()];
+				try {
+					to_digit_array(str, 0, result);
+				}
+				catch (std::invalid_argument&) {
+					delete[] result;
+					throw;
+				}
+				return result;
+			}
+			void to_digit_array(const std::string& str, const std::size_t& start, unsigned char* result) {
 				std::size_t len = str.size();
-				unsigned char* result = new unsigned char[len];
-				std::size_t i = 0;
+				std::size_t i = start;
 				while (i < len) {
 					if (0 <= str[i] - '0' && str[i] - '0' <= 9) {
-						result[i] = str[i] - '0';
+						result[i - start] = str[i] - '0';
 					}
 					else {
-						delete[] result;
 						throw std::invalid_argument("Input can contain only decimal digits!");
 					}
 					++i;
 				}
-				return result;
 			}
-			unsigned char times_radix(unsigned char* decimal_digits, 
+			limb times_radix(unsigned char* decimal_digits, 
 					const std::size_t& arr_len) {
-				unsigned char carry = 0;
-				unsigned int tmp;
+				double_limb carry = 0, tmp;
 				std::size_t i = arr_len;
 				while (i > 0) {
 					--i;
@@ -71,24 +1073,73 @@ namespace array_arithmetic {
 					decimal_digits[i] = tmp % 10;
 					carry = tmp / 10;
 				}
-				return carry;
+				return static_cast<limb>(carry);
 			}
-			unsigned char times_ten(unsigned char* radix_digits, const std::size_t& arr_len) {
-				unsigned char carry = 0;
-				unsigned int tmp;
+			unsigned char times_ten(limb* radix_digits, const std::size_t& arr_len) {
+				double_limb carry = 0, tmp;
 				std::size_t i = arr_len;
 				while (i > 0) {
 					--i;
-					tmp = carry + radix_digits[i] * 10;
-					radix_digits[i] = tmp % RADIX;
-					carry = tmp / RADIX;
+					tmp = carry + radix_digits[i] * static_cast<double_limb>(10);
+					radix_digits[i] = static_cast<limb>(tmp);
+					carry = tmp >> LIMB_BITS;
 				}
-				return carry;
+				return static_cast<unsigned char>(carry);
 			}
 		}
+		std::size_t power_of_ten_len(const std::size_t& exponent) {
+			// log2(10) < 3.322
+			return (exponent * 3322 / 1000) / LIMB_BITS + 2;
+		}
+		void power_of_ten(const std::size_t& exponent, limb* result, const std::size_t& result_len,
+				Workspace& ws) {
+			Workspace::Frame frame(ws);
+			const std::size_t WORKING_LEN = 2 * result_len + 1;
+			limb* current = ws.allocate(WORKING_LEN);
+			limb* square = ws.allocate(WORKING_LEN);
+			std::size_t current_len = 1;
+			current[0] = 1;
+			// left to right binary exponentiation
+			std::size_t bit = 0;
+			while ((exponent >> bit) > 1) { ++bit; }
+			for (std::size_t i = bit + 1; i > 0 && exponent > 0; ) {
+				--i;
+				multiply(current, current, square, current_len, current_len, ws);
+				const limb* trimmed = square;
+				current_len = 2 * current_len + 1;
+				trim(trimmed, current_len);
+				array_arithmetic::helpers::copy_into(trimmed, current, current_len, current_len);
+				if ((exponent >> i) & 1) {
+					limb carry = helpers::times_ten(current, current_len);
+					if (carry > 0) {
+						array_arithmetic::helpers::shift_right(current, 1, current_len + 1);
+						current[0] = carry;
+						++current_len;
+					}
+				}
+			}
+			array_arithmetic::helpers::set_to_zero(result, result_len - current_len);
+			array_arithmetic::helpers::copy_into(current, result + result_len - current_len, current_len, current_len);
+		}
+		void to_decimal_digits(const limb* arr, const std::size_t& arr_len, char* result,
+				const std::size_t& digits, Workspace& ws) {
+			const limb* powers[MAX_DECIMAL_LEVELS];
+			std::size_t power_lens[MAX_DECIMAL_LEVELS];
+			Workspace::Frame frame(ws);
+			decimal_powers(digits, powers, power_lens, ws);
+			decimal_digits(arr, arr_len, result, digits, powers, power_lens, ws);
+		}
+		void from_decimal_digits(const char* digits, const std::size_t& digits_len, limb* result,
+				const std::size_t& result_len, Workspace& ws) {
+			const limb* powers[MAX_DECIMAL_LEVELS];
+			std::size_t power_lens[MAX_DECIMAL_LEVELS];
+			Workspace::Frame frame(ws);
+			decimal_powers(digits_len, powers, power_lens, ws);
+			decimal_value(digits, digits_len, result, result_len, powers, power_lens, ws);
+		}
 	}
 	namespace helpers {
-		void copy_into(const unsigned char* source, unsigned char* target, const std::size_t&
+		void copy_into(const limb* source, limb* target, const std::size_t&
 				source_len, const std::size_t& target_len) {
 			std::size_t i;
 			for (i = 0; i < source_len; ++i) {
@@ -98,7 +1149,7 @@ namespace array_arithmetic {
 				target[i] = 0;
 			}
 		}
-		void shift_right(unsigned char* arr, const size_t& places, const size_t& arr_size) {
+		void shift_right(limb* arr, const size_t& places, const size_t& arr_size) {
 			std::size_t i = arr_size - places;
 			while (i > 0) {
 				--i;
@@ -110,27 +1161,64 @@ namespace array_arithmetic {
 				arr[i] = 0;
 			}
 		}
-		bool less_or_equal(const unsigned char* arr1, const unsigned char* arr2, 
+		bool less_or_equal(const limb* arr1, const limb* arr2, 
 															 const std::size_t& len) {
-			for (std::size_t i = 0; i < len; ++i) {
-				if (arr1[i] < arr2[i]) { return true; }
-				if (arr1[i] > arr2[i]) { return false; }
-				// loop continues only when arr1[i] == arr2[i]
-			}
-			// nothing was returned in the loop, so values are equal
-			return true;
+			return compare(arr1, arr2, len) <= 0;
 		}
-		bool is_zero(const unsigned char* arr, const std::size_t& len) {
-			for (std::size_t i = 0; i < len; ++i) {
-				if (arr[i] != 0) { return false; }
+		int compare(const limb* arr1, const limb* arr2, const std::size_t& len) {
+			std::size_t i = first_difference(arr1, arr2, len);
+			if (i == len) { return 0; }
+			return arr1[i] < arr2[i] ? -1 : 1;
+		}
+		bool within_ulps(const limb* arr1, const std::size_t& arr1_len, const limb* arr2,
+				const std::size_t& arr2_len, const limb& ulps) {
+			const std::size_t LEN = arr1_len < arr2_len ? arr1_len : arr2_len;
+			const limb* longer = arr1_len > arr2_len ? arr1 : arr2;
+			const std::size_t LONGER_LEN = arr1_len > arr2_len ? arr1_len : arr2_len;
+			std::size_t i = first_difference(arr1, arr2, LEN);
+			// the difference is then the rest of the longer array, less than 1 unit
+			// of the last common limb, and is within 0 units only if it is 0
+			if (i == LEN) { return ulps > 0 || is_zero(longer + LEN, LONGER_LEN - LEN); }
+			const limb* larger = arr1;
+			const limb* smaller = arr2;
+			if (arr1[i] < arr2[i]) {
+				larger = arr2;
+				smaller = arr1;
 			}
-			return true;
+			/**
+			 * the difference of the common limbs is below RADIX only if the leading
+			 * difference is 1 and is borrowed all the way to the last limb
+			 */
+			if (i < LEN - 1) {
+				if (larger[i] - smaller[i] != 1) { return false; }
+				for (++i; i < LEN - 1; ++i) {
+					if (larger[i] != 0 || smaller[i] != RADIX_MINUS_ONE) { return false; }
+				}
+				if (larger[LEN - 1] >= smaller[LEN - 1]) { return false; }
+			}
+			// wraps around to the difference if the leading limbs borrowed
+			limb head_diff = larger[LEN - 1] - smaller[LEN - 1];
+			if (head_diff > ulps) { return false; }
+			if (head_diff < ulps || arr1_len == arr2_len) { return true; }
+			/**
+			 * the remaining limbs of the longer array add to the difference if it is
+			 * the larger one and otherwise leave the difference below head_diff
+			 */
+			if (longer == smaller) { return true; }
+			return is_zero(longer + LEN, LONGER_LEN - LEN);
+		}
+		bool is_zero(const limb* arr, const std::size_t& len) {
+#ifdef ARRAY_ARITHMETIC_X86_SIMD
+			if (simd_level == SIMD_AVX2) { return avx2_is_zero(arr, len); }
+			if (simd_level == SIMD_SSE42) { return sse42_is_zero(arr, len); }
+#endif
+			return scalar_is_zero(arr, len);
 		}
-		void set_to_zero(unsigned char* arr, const std::size_t& len) {
+		void set_to_zero(limb* arr, const std::size_t& len) {
 			for (std::size_t i = 0; i < len; ++i) { arr[i] = 0; }
 		}
 		namespace division {
-			int align_dividend(unsigned char* dividend, const unsigned char* divisor, const std::size_t& len) {
+			int align_dividend(limb* dividend, const limb* divisor, const std::size_t& len) {
 				int result = 0;
 				while (less_or_equal(divisor, dividend, len)) {
 					bits::shift_right(dividend, 1, len);
@@ -138,7 +1226,7 @@ namespace array_arithmetic {
 				}
 				return result;
 			}
-			int align_divisor(const unsigned char* dividend, unsigned char* divisor, const std::size_t& len) {
+			int align_divisor(const limb* dividend, limb* divisor, const std::size_t& len) {
 			  int result = 0;
 				while (!less_or_equal(divisor, dividend, len)) {
 					bits::shift_right(divisor, 1, len);
@@ -146,12 +1234,12 @@ namespace array_arithmetic {
 				}
 				return result;
 			}
-			int align(unsigned char* dividend, unsigned char* divisor, const std::size_t& len) {
+			int align(limb* dividend, limb* divisor, const std::size_t& len) {
 				int result = align_dividend(dividend, divisor, len);
 				result += align_divisor(dividend, divisor, len);
 				return result;
 			}
-			int readjust(const unsigned char* dividend, unsigned char* divisor, const std::size_t& len) {
+			int readjust(const limb* dividend, limb* divisor, const std::size_t& len) {
 				int adjustment = 0;
 				while (!less_or_equal(divisor, dividend, len)) {
 					bits::shift_right(divisor, 1, len);
@@ -162,23 +1250,23 @@ namespace array_arithmetic {
 		}
 	}
 	namespace bits {
-		unsigned char get_mask(const std::size_t& bits_to_show) {
-			unsigned char result = 0;
-			for (std::size_t i = 0; i < bits_to_show; ++i) { result = 1 + (result << 1); }
+		limb get_mask(const std::size_t& bits_to_show) {
+			limb result = 0;
+			for (std::size_t i = 0; i < bits_to_show && i < LIMB_BITS; ++i) { result = 1 + (result << 1); }
 			return result;
 		}
-		void shift_right(unsigned char* arr, const std::size_t& places, const std::size_t& arr_size) {
-			std::size_t byte_places = places / 8;
-			std::size_t bit_places = places % 8;
-			helpers::shift_right(arr, byte_places, arr_size);
+		void shift_right(limb* arr, const std::size_t& places, const std::size_t& arr_size) {
+			std::size_t limb_places = places / LIMB_BITS;
+			std::size_t bit_places = places % LIMB_BITS;
+			helpers::shift_right(arr, limb_places, arr_size);
 			// now we only have to worry about bit_places
 			if (bit_places == 0) { return; }
-			unsigned char mask = get_mask(bit_places);
-			std::size_t offset = 8 - bit_places;
-			unsigned char tmp;
+			limb mask = get_mask(bit_places);
+			std::size_t offset = LIMB_BITS - bit_places;
+			limb tmp;
 			std::size_t i = arr_size - 1;
-			// the first byte_places positions are all 0, so we don't have to worry about them
-			while (i > byte_places) {
+			// the first limb_places positions are all 0, so we don't have to worry about them
+			while (i > limb_places) {
 				// shift the given position
 				arr[i] >>= bit_places;
 				// get the relevant bits from the position to the left and add them in
@@ -186,33 +1274,512 @@ namespace array_arithmetic {
 				arr[i] += (tmp << offset);
 				--i;
 			}
-			arr[byte_places] >>= bit_places;
+			arr[limb_places] >>= bit_places;
 		}
-		void set(unsigned char* arr, const std::size_t& bit_to_set) {
-			std::size_t array_index = bit_to_set / 8;
-			std::size_t bit_position = bit_to_set % 8;
-			unsigned char mask = 1 << (7 - bit_position);
+		void set(limb* arr, const std::size_t& bit_to_set) {
+			std::size_t array_index = bit_to_set / LIMB_BITS;
+			std::size_t bit_position = bit_to_set % LIMB_BITS;
+			limb mask = static_cast<limb>(1) << (LIMB_BITS - 1 - bit_position);
 			arr[array_index] |= mask;
 		}
 	}
 
+	Workspace::Frame::Frame(Workspace& ws) : ws(ws), mark(ws.get_mark()) {}
+
+	Workspace::Frame::~Frame() { ws.release(mark); }
+
+	Workspace::Workspace() : current_block(0), offset(0), in_use(0), peak(0) {}
+
+	Workspace::Workspace(const std::size_t& initial_limbs) : current_block(0), offset(0), in_use(0),
+			peak(0) {
+		if (initial_limbs > 0) { add_block(initial_limbs); }
+	}
+
+	Workspace::~Workspace() {
+		for (std::size_t i = 0; i < blocks.size(); ++i) { delete[] blocks[i].data; }
+	}
+
+	limb* Workspace::allocate(const std::size_t& len) {
+		// skip blocks without enough room left
+		while (current_block < blocks.size() && blocks[current_block].size - offset < len) {
+			++current_block;
+			offset = 0;
+		}
+		if (current_block == blocks.size()) {
+			std::size_t size = 2 * get_capacity();
+			if (size < MIN_BLOCK_LIMBS) { size = MIN_BLOCK_LIMBS; }
+			if (size < len) { size = len; }
+			add_block(size);
+		}
+		limb* result = blocks[current_block].data + offset;
+		offset += len;
+		in_use += len;
+		if (in_use > peak) { peak = in_use; }
+		return result;
+	}
+
+	Workspace::Mark Workspace::get_mark() const {
+		Mark result;
+		result.block = current_block;
+		result.offset = offset;
+		result.in_use = in_use;
+		return result;
+	}
+
+	void Workspace::release(const Mark& mark) {
+		current_block = mark.block;
+		offset = mark.offset;
+		in_use = mark.in_use;
+	}
+
+	std::size_t Workspace::get_in_use() const { return in_use; }
+
+	std::size_t Workspace::get_peak() const { return peak; }
+
+	void Workspace::reset_peak() { peak = in_use; }
+
+	std::size_t Workspace::get_capacity() const {
+		std::size_t result = 0;
+		for (std::size_t i = 0; i < blocks.size(); ++i) { result += blocks[i].size; }
+		return result;
+	}
+
+	Workspace& Workspace::local() {
+		thread_local Workspace ws;
+		return ws;
+	}
+
+	void Workspace::add_block(const std::size_t& size) {
+		Block block;
+		block.data = new limb[size];
+		block.size = size;
+		blocks.push_back(block);
+	}
+
+	struct Task {
+		std::function<void()> function;
+		TaskGroup* group;
+	};
+
+	class ThreadPool {
+	public:
+		explicit ThreadPool(const std::size_t& workers);
+		// stops the workers once they have finished their current task
+		~ThreadPool();
+		// queues task for the calling thread
+		void push(Task* task);
+		/**
+		 * the last task queued by the calling thread, else the oldest task
+		 * of another thread, or null if there is none
+		 */
+		Task* pop();
+		// runs task and counts it out of its group
+		void execute(Task* task);
+		/**
+		 * sleeps until group has no pending tasks or a task is queued, which the
+		 * waiting thread can then run
+		 */
+		void sleep(const TaskGroup& group);
+	private:
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Task*> tasks;
+		};
+		// 1 queue per worker, and a last one shared by threads outside the pool
+		std::vector<std::unique_ptr<Queue> > queues;
+		std::vector<std::thread> threads;
+		// workers sleep while there are no queued tasks, and threads in
+		// TaskGroup::wait() until a task is queued or their group has finished.
+		// sleep_mutex guards queued and the pending counts of the groups
+		std::mutex sleep_mutex;
+		std::condition_variable wake;
+		std::size_t queued;
+		bool stopping;
+		std::size_t own_queue() const;
+		void work(const std::size_t& index);
+		ThreadPool(const ThreadPool&);
+		ThreadPool& operator=(const ThreadPool&);
+	};
+
+	namespace {
+		// pool and queue of a worker thread
+		thread_local ThreadPool* worker_pool = 0;
+		thread_local std::size_t worker_index = 0;
+
+		std::size_t default_thread_count() {
+			const std::size_t HARDWARE_THREADS = std::thread::hardware_concurrency();
+			return HARDWARE_THREADS > 0 ? HARDWARE_THREADS : 1;
+		}
+		// guards thread_count and the creation of pool
+		std::mutex pool_mutex;
+		std::size_t thread_count = default_thread_count();
+		std::unique_ptr<ThreadPool> pool_storage;
+		std::atomic<ThreadPool*> pool(static_cast<ThreadPool*>(0));
+
+		// the pool, which is started by the first task, or null for 1 thread
+		ThreadPool* get_pool() {
+			ThreadPool* result = pool.load();
+			if (result != 0) { return result; }
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			if (thread_count > 1 && !pool_storage) {
+				pool_storage.reset(new ThreadPool(thread_count - 1));
+				pool.store(pool_storage.get());
+			}
+			return pool_storage.get();
+		}
+	}
+
+	ThreadPool::ThreadPool(const std::size_t& workers) : queued(0), stopping(false) {
+		for (std::size_t i = 0; i <= workers; ++i) { queues.push_back(std::unique_ptr<Queue>(new Queue)); }
+		for (std::size_t i = 0; i < workers; ++i) { threads.push_back(std::thread(&ThreadPool::work, this, i)); }
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::size_t i = 0; i < threads.size(); ++i) { threads[i].join(); }
+	}
+
+	std::size_t ThreadPool::own_queue() const {
+		return worker_pool == this ? worker_index : queues.size() - 1;
+	}
+
+	void ThreadPool::push(Task* task) {
+		Queue& queue = *queues[own_queue()];
+		{
+			// counted before pop() can take the task and count it out, so queued can't wrap
+			std::lock_guard<std::mutex> sleep_lock(sleep_mutex);
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(task);
+			++queued;
+		}
+		wake.notify_one();
+	}
+
+	Task* ThreadPool::pop() {
+		const std::size_t OWN = own_queue();
+		Task* result = 0;
+		for (std::size_t i = 0; i < queues.size() && result == 0; ++i) {
+			Queue& queue = *queues[(OWN + i) % queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.tasks.empty()) { continue; }
+			if (i == 0) {
+				result = queue.tasks.back();
+				queue.tasks.pop_back();
+			}
+			else {
+				result = queue.tasks.front();
+				queue.tasks.pop_front();
+			}
+		}
+		if (result != 0) {
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+			--queued;
+		}
+		return result;
+	}
+
+	void ThreadPool::execute(Task* task) {
+		TaskGroup* group = task->group;
+		group->execute(task->function);
+		delete task;
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		// the group isn't used once its count reaches 0, since its waiter may return
+		if (--group->pending == 0) { wake.notify_all(); }
+	}
+
+	void ThreadPool::sleep(const TaskGroup& group) {
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		wake.wait(lock, [this, &group]() { return group.pending == 0 || queued > 0; });
+	}
+
+	void ThreadPool::work(const std::size_t& index) {
+		worker_pool = this;
+		worker_index = index;
+		while (true) {
+			Task* task = pop();
+			if (task != 0) {
+				execute(task);
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+			if (stopping) { return; }
+			if (queued == 0) { wake.wait(lock); }
+		}
+	}
+
+	std::size_t get_thread_count() {
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		return thread_count;
+	}
+
+	void set_thread_count(const std::size_t& threads) {
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		thread_count = threads > 0 ? threads : 1;
+		pool.store(static_cast<ThreadPool*>(0));
+		pool_storage.reset();
+	}
+
+	TaskGroup::TaskGroup() : pending(0) {}
+
+	TaskGroup::~TaskGroup() {
+		try { wait(); }
+		catch (...) {}
+	}
+
+	void TaskGroup::run(const std::function<void()>& task) {
+		ThreadPool* thread_pool = get_pool();
+		if (thread_pool == 0) {
+			execute(task);
+			return;
+		}
+		Task* queued_task = new Task;
+		queued_task->function = task;
+		queued_task->group = this;
+		++pending;
+		thread_pool->push(queued_task);
+	}
+
+	void TaskGroup::wait() {
+		ThreadPool* thread_pool = pool.load();
+		while (pending > 0) {
+			Task* task = thread_pool->pop();
+			if (task != 0) { thread_pool->execute(task); }
+			// the remaining tasks are running on other threads, which may queue more
+			else { thread_pool->sleep(*this); }
+		}
+		std::lock_guard<std::mutex> lock(error_mutex);
+		if (error) {
+			std::exception_ptr first_error = error;
+			error = std::exception_ptr();
+			std::rethrow_exception(first_error);
+		}
+	}
+
+	void TaskGroup::execute(const std::function<void()>& task) {
+		try { task(); }
+		catch (...) {
+			std::lock_guard<std::mutex> lock(error_mutex);
+			if (!error) { error = std::current_exception(); }
+		}
+	}
+
+	std::size_t karatsuba_threshold = KARATSUBA_THRESHOLD;
+
+	std::size_t toom3_threshold = TOOM3_THRESHOLD;
+
+	std::size_t toom4_threshold = TOOM4_THRESHOLD;
+
+	std::size_t ntt_threshold = NTT_THRESHOLD;
+
+	std::size_t parallel_threshold = PARALLEL_THRESHOLD;
+
 	/**
 	 * result is assumed to have length a_len + b_len + 1
 	 * this needs to be set up so that b_len <= a_len
+	 * a = a1 * RADIX^m + a0 and b = b1 * RADIX^m + b0, where a0 and b0 are
+	 * the last m digits, so that
+	 * a * b = z2 * RADIX^(2m) + z1 * RADIX^m + z0 with
+	 * z2 = a1 * b1, z0 = a0 * b0 and z1 = (a1 + a0) * (b1 + b0) - z2 - z0
 	 */
-	void karatsuba_multiply(const unsigned char* a, const unsigned char* b,
-			unsigned char* result, const std::size_t& a_len, const std::size_t& b_len) {
+	void karatsuba_multiply(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len, Workspace& ws) {
+		// the recursion only shrinks the sums a1 + a0 and b1 + b0 for lengths of at least 4
+		if (b_len < karatsuba_threshold || b_len < 4) {
+			school_multiply(a, b, result, a_len, b_len);
+			return;
+		}
+		// splitting at a_len / 2 requires b to have more than m digits
+		if (2 * b_len <= a_len) {
+			multiply_slices(a, b, result, a_len, b_len, karatsuba_multiply, ws);
+			return;
+		}
+		const std::size_t RESULT_LEN = a_len + b_len + 1;
+		const std::size_t M = a_len / 2;
+		const std::size_t A1_LEN = a_len - M;
+		const std::size_t B1_LEN = b_len - M;
+		const limb* a0 = a + A1_LEN;
+		const limb* b0 = b + B1_LEN;
+		// a1 + a0 and b1 + b0 each get an extra leading digit for the carry
+		const std::size_t SUM_A_LEN = A1_LEN + 1;
+		const std::size_t SUM_B_LEN = (B1_LEN > M ? B1_LEN : M) + 1;
+		const std::size_t Z0_LEN = 2 * M + 1;
+		const std::size_t Z2_LEN = A1_LEN + B1_LEN + 1;
+		const std::size_t Z1_LEN = SUM_A_LEN + SUM_B_LEN + 1;
+		Workspace::Frame frame(ws);
+		limb* sum_a = ws.allocate(SUM_A_LEN);
+		limb* sum_b = ws.allocate(SUM_B_LEN);
+		limb* z0 = ws.allocate(Z0_LEN);
+		limb* z1 = ws.allocate(Z1_LEN);
+		limb* z2 = ws.allocate(Z2_LEN);
+
+		add(a, a0, sum_a, A1_LEN, M);
+		if (B1_LEN >= M) { add(b, b0, sum_b, B1_LEN, M); }
+		else { add(b0, b, sum_b, M, B1_LEN); }
+		SubProducts products(b_len, ws);
+		products.run([=](Workspace& task_ws) { karatsuba_multiply(a0, b0, z0, M, M, task_ws); });
+		products.run([=](Workspace& task_ws) { karatsuba_multiply(a, b, z2, A1_LEN, B1_LEN, task_ws); });
+		products.run([=](Workspace& task_ws) {
+			if (SUM_B_LEN <= SUM_A_LEN) { karatsuba_multiply(sum_a, sum_b, z1, SUM_A_LEN, SUM_B_LEN, task_ws); }
+			else { karatsuba_multiply(sum_b, sum_a, z1, SUM_B_LEN, SUM_A_LEN, task_ws); }
+		});
+		products.wait();
+		subtract_from(z1, Z1_LEN, z0, Z0_LEN);
+		subtract_from(z1, Z1_LEN, z2, Z2_LEN);
+
+		helpers::set_to_zero(result, RESULT_LEN);
+		add_into(result, RESULT_LEN, z0, Z0_LEN, 0);
+		add_into(result, RESULT_LEN, z1, Z1_LEN, M);
+		add_into(result, RESULT_LEN, z2, Z2_LEN, 2 * M);
 	}
 	
+	void toom3_multiply(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len, Workspace& ws) {
+		if (2 * b_len <= a_len) { multiply_slices(a, b, result, a_len, b_len, toom3_multiply, ws); }
+		else { toom_multiply(a, b, result, a_len, b_len, 3, ws); }
+	}
+
+	void toom4_multiply(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len, Workspace& ws) {
+		if (2 * b_len <= a_len) { multiply_slices(a, b, result, a_len, b_len, toom4_multiply, ws); }
+		else { toom_multiply(a, b, result, a_len, b_len, 4, ws); }
+	}
+
+	/**
+	 * The product is the convolution of the limbs, computed modulo 3 primes by
+	 * number theoretic transforms and reconstructed with the Chinese remainder
+	 * theorem (Garner's algorithm): x = v1 + p1 * (v2 + p2 * v3) with
+	 * v1 = x mod p1, v2 = (x - v1) / p1 mod p2 and v3 = (x - v1 - p1 * v2) / (p1 * p2) mod p3
+	 */
+	void ntt_multiply(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len, Workspace& ws) {
+		if (a_len + b_len > NTT_MAX_LEN) {
+			toom_multiply(a, b, result, a_len, b_len, 4, ws);
+			return;
+		}
+		const std::size_t RESULT_LEN = a_len + b_len + 1;
+		std::size_t n = 1;
+		while (n < a_len + b_len - 1) { n <<= 1; }
+		Workspace::Frame frame(ws);
+		limb* residues_1 = ws.allocate(n);
+		limb* residues_2 = ws.allocate(n);
+		limb* residues_3 = ws.allocate(n);
+		// the convolutions modulo the 3 primes run concurrently, each with its own scratch
+		const bool CONCURRENT = split_work(b_len);
+		limb* scratch_1 = ws.allocate(2 * n);
+		limb* scratch_2 = CONCURRENT ? ws.allocate(2 * n) : scratch_1;
+		limb* scratch_3 = CONCURRENT ? ws.allocate(2 * n) : scratch_1;
+		TaskGroup convolutions;
+		if (CONCURRENT) {
+			convolutions.run([=] {
+				convolution<NTT_PRIME_2, NTT_GENERATOR>(a, a_len, b, b_len, residues_2, n, scratch_2, true);
+			});
+			convolutions.run([=] {
+				convolution<NTT_PRIME_3, NTT_GENERATOR>(a, a_len, b, b_len, residues_3, n, scratch_3, true);
+			});
+			convolution<NTT_PRIME_1, NTT_GENERATOR>(a, a_len, b, b_len, residues_1, n, scratch_1, true);
+		}
+		else {
+			convolution<NTT_PRIME_1, NTT_GENERATOR>(a, a_len, b, b_len, residues_1, n, scratch_1, false);
+			convolution<NTT_PRIME_2, NTT_GENERATOR>(a, a_len, b, b_len, residues_2, n, scratch_2, false);
+			convolution<NTT_PRIME_3, NTT_GENERATOR>(a, a_len, b, b_len, residues_3, n, scratch_3, false);
+		}
+		convolutions.wait();
+		const double_limb P1_INVERSE = power_modulo(NTT_PRIME_1, NTT_PRIME_2 - 2, NTT_PRIME_2);
+		const double_limb P1_MOD_P3 = NTT_PRIME_1 % NTT_PRIME_3;
+		const double_limb P1_P2_MOD_P3 = P1_MOD_P3 * NTT_PRIME_2 % NTT_PRIME_3;
+		const double_limb P1_P2_INVERSE = power_modulo(static_cast<limb>(P1_P2_MOD_P3), NTT_PRIME_3 - 2, NTT_PRIME_3);
+		// coefficient k of the convolution is added in at RESULT_LEN - 1 - k, with the
+		// carry kept in 4 limbs
+		limb coefficient[3], carry[4] = {0, 0, 0, 0};
+		double_limb v1, v2, v3, tmp;
+		for (std::size_t k = 0; k + 1 < RESULT_LEN; ++k) {
+			if (k < a_len + b_len - 1) {
+				v1 = residues_1[k];
+				v2 = (residues_2[k] + NTT_PRIME_2 - v1 % NTT_PRIME_2) * P1_INVERSE % NTT_PRIME_2;
+				tmp = (v1 % NTT_PRIME_3 + P1_MOD_P3 * v2) % NTT_PRIME_3;
+				v3 = (residues_3[k] + NTT_PRIME_3 - tmp) * P1_P2_INVERSE % NTT_PRIME_3;
+				// v3 * p2 + v2 < 2^58
+				tmp = v3 * NTT_PRIME_2 + v2;
+				coefficient[0] = 0;
+				coefficient[1] = static_cast<limb>(tmp >> LIMB_BITS);
+				coefficient[2] = static_cast<limb>(tmp);
+				multiply_by_limb(coefficient, 3, NTT_PRIME_1);
+				limb v1_limb = static_cast<limb>(v1);
+				add_into(coefficient, 3, &v1_limb, 1, 0);
+				add_into(carry, 4, coefficient, 3, 0);
+			}
+			result[RESULT_LEN - 1 - k] = carry[3];
+			helpers::shift_right(carry, 1, 4);
+		}
+		result[0] = carry[3];
+	}
+
+	void multiply(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len, Workspace& ws) {
+		if (a == b && a_len == b_len) { square(a, result, a_len, ws); }
+		else if (b_len < toom3_threshold) { karatsuba_multiply(a, b, result, a_len, b_len, ws); }
+		else if (2 * b_len <= a_len) { multiply_slices(a, b, result, a_len, b_len, multiply, ws); }
+		else if (b_len < toom4_threshold) { toom_multiply(a, b, result, a_len, b_len, 3, ws); }
+		else if (b_len < ntt_threshold || a_len + b_len > NTT_MAX_LEN) {
+			toom_multiply(a, b, result, a_len, b_len, 4, ws);
+		}
+		else { ntt_multiply(a, b, result, a_len, b_len, ws); }
+	}
+
+	void add_multiply_by_limb(const limb* a, const limb* b, const limb& factor,
+			const std::size_t& shift, limb* result, const std::size_t& len) {
+		// the limbs of a + b are formed with their own carry, so that each product
+		// fits in a double_limb. a[i] and b[i] go to result[i + shift], which
+		// has already been read when result is a or b
+		double_limb sum_carry = 0, product_carry = 0, tmp;
+		std::size_t i = len;
+		while (i > 0) {
+			--i;
+			tmp = sum_carry + a[i] + (b == 0 ? 0 : b[i]);
+			sum_carry = tmp >> LIMB_BITS;
+			tmp = static_cast<double_limb>(static_cast<limb>(tmp)) * factor + product_carry;
+			product_carry = tmp >> LIMB_BITS;
+			if (i + shift < len) { result[i + shift] = static_cast<limb>(tmp); }
+		}
+		// the carries fill the top shift limbs
+		tmp = sum_carry * factor + product_carry;
+		i = shift < len ? shift : len;
+		while (i > 0) {
+			--i;
+			result[i] = static_cast<limb>(tmp);
+			tmp >>= LIMB_BITS;
+		}
+	}
+
+	void short_multiply(const limb* a, const limb* b, limb* result, const std::size_t& len,
+			const std::size_t& result_len, Workspace& ws) {
+		const std::size_t PRODUCT_LEN = 2 * len + 1;
+		Workspace::Frame frame(ws);
+		// the triangles no longer pay off against Toom-4 and NTT products
+		if (result_len + 2 >= PRODUCT_LEN || len >= toom4_threshold) {
+			limb* product = ws.allocate(PRODUCT_LEN);
+			multiply(a, b, product, len, len, ws);
+			helpers::copy_into(product, result, result_len, result_len);
+			return;
+		}
+		limb* high = ws.allocate(result_len + 2);
+		high_product(a, len, b, len, result_len - 1, high, ws);
+		helpers::copy_into(high, result, result_len, result_len);
+	}
+
 	/**
 	 * result is assumed to have length a_len + b_len + 1
 	 * this needs to be set up so that b_len <= a_len
 	 */
-	void school_multiply(const unsigned char* a, const unsigned char* b,
-			unsigned char* result, const std::size_t& a_len, const std::size_t& b_len) {
+	void school_multiply(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len) {
 		// end_pos tracks the least significant digit in the result array
 		std::size_t a_index, b_index, result_index, end_pos;
-		unsigned int carry, tmp;
+		double_limb carry, tmp;
 		const std::size_t RESULT_LEN = a_len + b_len + 1;
 		// initialize result to 0
 		for (result_index = 0; result_index < RESULT_LEN; ++result_index) {
@@ -228,142 +1795,304 @@ namespace array_arithmetic {
 			while (a_index > 0) {
 				--a_index;
 				--result_index;
-				tmp = carry + result[result_index] + a[a_index] * b[b_index];
-				result[result_index] = tmp % RADIX;
-				carry = tmp / RADIX;
+				tmp = carry + result[result_index] + static_cast<double_limb>(a[a_index]) * b[b_index];
+				result[result_index] = static_cast<limb>(tmp);
+				carry = tmp >> LIMB_BITS;
 			}
-			result[result_index - 1] = carry;
+			result[result_index - 1] = static_cast<limb>(carry);
 			--end_pos;
 		}
 	}
 
-	void add(const unsigned char* a, const unsigned char* b, unsigned char* result,
-			const std::size_t& len) {
-		unsigned int carry = 0, tmp_sum;
-		std::size_t i = len;
-		while (i > 0) {
-			--i;
-			tmp_sum = carry + a[i] + b[i];
-			result[i] = tmp_sum % RADIX;
-			carry = tmp_sum / RADIX;
+	/**
+	 * a = a1 * RADIX^m + a0, so that
+	 * a^2 = z2 * RADIX^(2m) + z1 * RADIX^m + z0 with
+	 * z2 = a1^2, z0 = a0^2 and z1 = (a1 + a0)^2 - z2 - z0
+	 */
+	void karatsuba_square(const limb* a, limb* result, const std::size_t& len, Workspace& ws) {
+		if (len < karatsuba_threshold || len < 4) {
+			school_square(a, result, len);
+			return;
+		}
+		const std::size_t RESULT_LEN = 2 * len + 1;
+		const std::size_t M = len / 2;
+		const std::size_t A1_LEN = len - M;
+		const limb* a0 = a + A1_LEN;
+		const std::size_t SUM_LEN = A1_LEN + 1;
+		const std::size_t Z0_LEN = 2 * M + 1;
+		const std::size_t Z2_LEN = 2 * A1_LEN + 1;
+		const std::size_t Z1_LEN = 2 * SUM_LEN + 1;
+		Workspace::Frame frame(ws);
+		limb* sum = ws.allocate(SUM_LEN);
+		limb* z0 = ws.allocate(Z0_LEN);
+		limb* z1 = ws.allocate(Z1_LEN);
+		limb* z2 = ws.allocate(Z2_LEN);
+
+		add(a, a0, sum, A1_LEN, M);
+		SubProducts products(len, ws);
+		products.run([=](Workspace& task_ws) { karatsuba_square(a0, z0, M, task_ws); });
+		products.run([=](Workspace& task_ws) { karatsuba_square(a, z2, A1_LEN, task_ws); });
+		products.run([=](Workspace& task_ws) { karatsuba_square(sum, z1, SUM_LEN, task_ws); });
+		products.wait();
+		subtract_from(z1, Z1_LEN, z0, Z0_LEN);
+		subtract_from(z1, Z1_LEN, z2, Z2_LEN);
+
+		helpers::set_to_zero(result, RESULT_LEN);
+		add_into(result, RESULT_LEN, z0, Z0_LEN, 0);
+		add_into(result, RESULT_LEN, z1, Z1_LEN, M);
+		add_into(result, RESULT_LEN, z2, Z2_LEN, 2 * M);
+	}
+
+	void toom3_square(const limb* a, limb* result, const std::size_t& len, Workspace& ws) {
+		toom_multiply(a, a, result, len, len, 3, ws);
+	}
+
+	void toom4_square(const limb* a, limb* result, const std::size_t& len, Workspace& ws) {
+		toom_multiply(a, a, result, len, len, 4, ws);
+	}
+
+	void ntt_square(const limb* a, limb* result, const std::size_t& len, Workspace& ws) {
+		ntt_multiply(a, a, result, len, len, ws);
+	}
+
+	void square(const limb* a, limb* result, const std::size_t& len, Workspace& ws) {
+		if (len < toom3_threshold) { karatsuba_square(a, result, len, ws); }
+		else if (len < toom4_threshold) { toom_multiply(a, a, result, len, len, 3, ws); }
+		else if (len < ntt_threshold || 2 * len > NTT_MAX_LEN) {
+			toom_multiply(a, a, result, len, len, 4, ws);
 		}
+		else { ntt_multiply(a, a, result, len, len, ws); }
 	}
 
-	void add(const unsigned char* a, const unsigned char* b,
-			unsigned char* result, const std::size_t& a_len, const std::size_t& b_len) {
-		unsigned int carry = 0, tmp_sum;
-		unsigned int a_b_diff = a_len - b_len;
-		std::size_t i = b_len;
+	/**
+	 * each cross product a[i] * a[j] with i != j is computed once and doubled,
+	 * then the squares a[i]^2 on the diagonal are added
+	 */
+	void school_square(const limb* a, limb* result, const std::size_t& len) {
+		const std::size_t RESULT_LEN = 2 * len + 1;
+		std::size_t i, j;
+		double_limb carry, tmp;
+		helpers::set_to_zero(result, RESULT_LEN);
+		// a[i] * a[j] belongs at index i + j + 2
+		i = len;
 		while (i > 0) {
 			--i;
-			tmp_sum = carry + a[i + a_b_diff] + b[i];
-			result[i + a_b_diff + 1] = tmp_sum % RADIX;
-			carry = tmp_sum / RADIX;
+			carry = 0;
+			j = i;
+			while (j > 0) {
+				--j;
+				tmp = carry + result[i + j + 2] + static_cast<double_limb>(a[i]) * a[j];
+				result[i + j + 2] = static_cast<limb>(tmp);
+				carry = tmp >> LIMB_BITS;
+			}
+			result[i + 1] = static_cast<limb>(carry);
 		}
-		i = a_b_diff;
+		// double the cross products
+		limb high_bit = 0, next_bit;
+		i = RESULT_LEN;
 		while (i > 0) {
 			--i;
-			tmp_sum = carry + a[i];
-			result[i + 1] = tmp_sum % RADIX;
-			carry = tmp_sum / RADIX;
+			next_bit = result[i] >> (LIMB_BITS - 1);
+			result[i] = (result[i] << 1) | high_bit;
+			high_bit = next_bit;
 		}
-		result[0] = carry;
+		carry = 0;
+		i = len;
+		while (i > 0) {
+			--i;
+			double_limb diagonal = static_cast<double_limb>(a[i]) * a[i];
+			tmp = carry + result[2 * i + 2] + static_cast<limb>(diagonal);
+			result[2 * i + 2] = static_cast<limb>(tmp);
+			carry = tmp >> LIMB_BITS;
+			tmp = carry + result[2 * i + 1] + (diagonal >> LIMB_BITS);
+			result[2 * i + 1] = static_cast<limb>(tmp);
+			carry = tmp >> LIMB_BITS;
+		}
+		result[0] += static_cast<limb>(carry);
 	}
 
-	void subtract(const unsigned char* a, const unsigned char* b, unsigned char* result,
+	void add(const limb* a, const limb* b, limb* result,
 			const std::size_t& len) {
-		std::size_t i;
-		// copy of a is needed because we have to modify it when we borrow
-		unsigned char* a_copy = new unsigned char[len];
-		for (i = 0; i < len; ++i) { a_copy[i] = a[i]; }
-		i = len;
-		int borrow_index;
+		add_with_carry(a, b, result, len, 0);
+	}
+
+	void add(const limb* a, const limb* b,
+			limb* result, const std::size_t& a_len, const std::size_t& b_len) {
+		double_limb tmp_sum;
+		std::size_t a_b_diff = a_len - b_len;
+		double_limb carry = add_with_carry(a + a_b_diff, b, result + a_b_diff + 1, b_len, 0);
+		std::size_t i = a_b_diff;
 		while (i > 0) {
 			--i;
-			if (a_copy[i] >= b[i]) { result[i] = a_copy[i] - b[i]; }
-			else {
-				result[i] = RADIX + a_copy[i] - b[i];
-				borrow_index = i - 1;
-				// get to a point where there is something to borrow
-				while (borrow_index > 0 && a_copy[borrow_index] == 0) {
-					a_copy[borrow_index--] = RADIX_MINUS_ONE;
-				}
-				--a_copy[borrow_index];
-			}
+			tmp_sum = carry + a[i];
+			result[i + 1] = static_cast<limb>(tmp_sum);
+			carry = tmp_sum >> LIMB_BITS;
 		}
-		delete[] a_copy;
+		result[0] = static_cast<limb>(carry);
+	}
+
+	void subtract(const limb* a, const limb* b, limb* result,
+			const std::size_t& len) {
+		subtract_with_borrow(a, b, result, len, 0);
 	}
-	void subtract(const unsigned char* a, const unsigned char* b, unsigned char* result,
+	void subtract(const limb* a, const limb* b, limb* result,
 			const std::size_t& a_len, const std::size_t& b_len) {
-		std::size_t i;
-		// copy of a is needed because we have to modify it when we borrow
-		unsigned char* a_copy = new unsigned char[a_len];
-		for (i = 0; i < a_len; ++i) { a_copy[i] = a[i]; }
 		std::size_t ab_len_diff = a_len - b_len;
-		i = b_len;
-		int borrow_index;
+		limb borrow = subtract_with_borrow(a + ab_len_diff, b, result + ab_len_diff, b_len, 0);
+		// the borrow passes through the leading zeros of a
+		std::size_t i = ab_len_diff;
+		limb a_i;
 		while (i > 0) {
 			--i;
-			if (a_copy[i + ab_len_diff] >= b[i]) { result[i + ab_len_diff] = a_copy[i + ab_len_diff] - b[i]; }
-			else {
-				result[i + ab_len_diff] = RADIX + a_copy[i + ab_len_diff] - b[i];
-				borrow_index = i + ab_len_diff - 1;
-				// get to a point where there is something to borrow
-				while (borrow_index > 0 && a_copy[borrow_index] == 0) {
-					a_copy[borrow_index--] = RADIX_MINUS_ONE;
-				}
-				--a_copy[borrow_index];
-			}
+			a_i = a[i];
+			result[i] = a_i - borrow;
+			borrow &= static_cast<limb>(a_i == 0);
 		}
-		i = ab_len_diff;
-		while (i > 0) {
-			--i;
-			result[i] = a_copy[i];
-		}
-		delete[] a_copy;
 	}
-	void divide(const unsigned char* dividend, const unsigned char* divisor, unsigned char* result,
-			const std::size_t& len, const std::size_t& int_digits) {
+	/**
+	 * Knuth's Algorithm D (The Art of Computer Programming, Vol. 2, 4.3.1)
+	 * dividend * RADIX^(len - int_digits) and divisor are divided as integers.
+	 * Both are first shifted left until the top bit of the divisor is set. Each
+	 * quotient limb is then estimated from the 2 leading limbs of the remainder and
+	 * the leading limb of the divisor, checked against the next limbs, and the
+	 * estimate times the divisor is subtracted from the remainder. The estimate
+	 * is at most 1 too large after the check, in which case the divisor is added back
+	 */
+	void divide(const limb* dividend, const limb* divisor, limb* result,
+			const std::size_t& len, const std::size_t& int_digits, Workspace& ws) {
 		// throw exception if client tries to divide by 0
 		if (helpers::is_zero(divisor, len)) {
 			throw std::invalid_argument("Division by 0 is not allowed!");
-    }
+		}
 		// initialize result to 0
 		helpers::set_to_zero(result, len);
 		// we are done if dividend is 0, so return
 		if (helpers::is_zero(dividend, len)) { return; }
-		// we will need copies of double size for manipulation
-		const std::size_t WORKING_LEN = len * 2;
-		// this is the bit length of the original values (not the expanded copies)
-		const std::size_t BIT_LENGTH = len * 8;
-		// 2 dividend arrays are needed because we need to subtract, then use result as new dividend
-		unsigned char* dividend_copy1 = new unsigned char[WORKING_LEN];
-		unsigned char* dividend_copy2 = new unsigned char[WORKING_LEN];
-		unsigned char* divisor_copy = new unsigned char[WORKING_LEN];
-		// copy dividend into copy1 (we don't yet need to do anything with dividend_copy2)
-		helpers::copy_into(dividend, dividend_copy1, len, WORKING_LEN);
-		helpers::copy_into(divisor, divisor_copy, len, WORKING_LEN);
-		int starting_bit = int_digits * 8 - 1;
-		starting_bit += helpers::division::align(dividend_copy1, divisor_copy, WORKING_LEN);
-		bool throw_overflow_exception = (starting_bit < 0);
-		std::size_t nonnegative_starting_bit = starting_bit;
-		if (!throw_overflow_exception) {
-			while (nonnegative_starting_bit < BIT_LENGTH) {
-				bits::set(result, nonnegative_starting_bit);
-				subtract(dividend_copy1, divisor_copy, dividend_copy2, WORKING_LEN);
-				nonnegative_starting_bit += helpers::division::readjust(dividend_copy2, divisor_copy, WORKING_LEN);
-				// check the condition of the while loop since we are using double storage
-				if (nonnegative_starting_bit >= BIT_LENGTH) { break; }
-				bits::set(result, nonnegative_starting_bit);
-				subtract(dividend_copy2, divisor_copy, dividend_copy1, WORKING_LEN);
-				nonnegative_starting_bit += helpers::division::readjust(dividend_copy1, divisor_copy, WORKING_LEN);
-			}
-		}
-		delete[] dividend_copy1;
-		delete[] dividend_copy2;
-		delete[] divisor_copy;
-		if (throw_overflow_exception) {
+		const std::size_t FRACTIONAL_LEN = len - int_digits;
+		const limb TOP_BIT = static_cast<limb>(1) << (LIMB_BITS - 1);
+		Workspace::Frame frame(ws);
+		// normalized divisor
+		const limb* divisor_trimmed = divisor;
+		std::size_t d_len = len;
+		trim(divisor_trimmed, d_len);
+		std::size_t shift = 0;
+		for (limb top = divisor_trimmed[0]; (top & TOP_BIT) == 0; top <<= 1) { ++shift; }
+		limb* d = ws.allocate(d_len);
+		shift_left_bits(divisor_trimmed, d_len, d, d_len, shift);
+		// the remainder starts as the shifted dividend with an extra leading limb,
+		// followed by the fractional places of the quotient
+		const std::size_t U_LEN = len + 1 + FRACTIONAL_LEN;
+		const std::size_t Q_LEN = U_LEN - d_len;
+		limb* u = ws.allocate(U_LEN);
+		limb* q = ws.allocate(Q_LEN);
+		shift_left_bits(dividend, len, u, len + 1, shift);
+		helpers::set_to_zero(u + len + 1, FRACTIONAL_LEN);
+		const double_limb D0 = d[0];
+		const double_limb D1 = d_len > 1 ? d[1] : 0;
+		double_limb q_hat, r_hat, product;
+		std::int64_t tmp, carry;
+		for (std::size_t j = 0; j < Q_LEN; ++j) {
+			// u[j] <= D0, and u[j] == D0 can make the estimate RADIX
+			double_limb top = (static_cast<double_limb>(u[j]) << LIMB_BITS) | u[j + 1];
+			q_hat = top / D0;
+			r_hat = top % D0;
+			double_limb next = d_len > 1 ? u[j + 2] : 0;
+			while (q_hat >= RADIX || q_hat * D1 > ((r_hat << LIMB_BITS) | next)) {
+				--q_hat;
+				r_hat += D0;
+				if (r_hat >= RADIX) { break; }
+			}
+			// multiply and subtract from u[j..j + d_len]
+			carry = 0;
+			std::size_t i = d_len;
+			while (i > 0) {
+				--i;
+				product = q_hat * d[i];
+				tmp = u[j + 1 + i] - carry - static_cast<std::int64_t>(product & RADIX_MINUS_ONE);
+				u[j + 1 + i] = static_cast<limb>(tmp);
+				carry = static_cast<std::int64_t>(product >> LIMB_BITS) - (tmp >> LIMB_BITS);
+			}
+			tmp = u[j] - carry;
+			u[j] = static_cast<limb>(tmp);
+			if (tmp < 0) {
+				// the estimate was 1 too large
+				--q_hat;
+				add_into(u + j, d_len + 1, d, d_len, 0);
+			}
+			q[j] = static_cast<limb>(q_hat);
+		}
+		if (Q_LEN > len && !helpers::is_zero(q, Q_LEN - len)) {
+			throw std::overflow_error("Result of division is too large to compute!");
+		}
+		if (Q_LEN >= len) { helpers::copy_into(q + Q_LEN - len, result, len, len); }
+		else { helpers::copy_into(q, result + len - Q_LEN, Q_LEN, Q_LEN); }
+	}
+
+	std::size_t newton_division_threshold = NEWTON_DIVISION_THRESHOLD;
+
+	/**
+	 * dividend * RADIX^(len - int_digits) and divisor are divided as integers.
+	 * Both are shifted left until the top bit of the divisor is set, and the
+	 * quotient is estimated by multiplying with the reciprocal of the divisor.
+	 * The estimate is off by at most a few units, so correcting it with the
+	 * remainder makes the result the same as that of divide()
+	 */
+	void newton_divide(const limb* dividend, const limb* divisor, limb* result,
+			const std::size_t& len, const std::size_t& int_digits, Workspace& ws) {
+		if (helpers::is_zero(divisor, len)) {
+			throw std::invalid_argument("Division by 0 is not allowed!");
+		}
+		helpers::set_to_zero(result, len);
+		if (helpers::is_zero(dividend, len)) { return; }
+		const std::size_t FRACTIONAL_LEN = len - int_digits;
+		const limb ONE = 1;
+		const limb TOP_BIT = static_cast<limb>(1) << (LIMB_BITS - 1);
+		Workspace::Frame frame(ws);
+		// normalized divisor
+		const limb* divisor_trimmed = divisor;
+		std::size_t d_len = len;
+		trim(divisor_trimmed, d_len);
+		std::size_t shift = 0;
+		for (limb top = divisor_trimmed[0]; (top & TOP_BIT) == 0; top <<= 1) { ++shift; }
+		limb* d = ws.allocate(d_len);
+		shift_left_bits(divisor_trimmed, d_len, d, d_len, shift);
+		// dividend shifted by the same number of bits needs an extra limb
+		limb* dividend_shifted = ws.allocate(len + 1);
+		shift_left_bits(dividend, len, dividend_shifted, len + 1, shift);
+		const limb* a = dividend_shifted;
+		std::size_t a_len = len + 1;
+		trim(a, a_len);
+		// length of the numerator a * RADIX^FRACTIONAL_LEN
+		const std::size_t N_LEN = a_len + FRACTIONAL_LEN;
+		if (N_LEN < d_len) { return; }
+		// the quotient has at most N_LEN - d_len + 1 limbs, and the estimate gets 1 more
+		const std::size_t PRECISION = N_LEN - d_len + 2;
+		const std::size_t Q_LEN = PRECISION;
+		const std::size_t R_LEN = Q_LEN + d_len + 1;
+		limb* x = ws.allocate(PRECISION + 1);
+		limb* q = ws.allocate(a_len + PRECISION + 2);
+		limb* numerator = ws.allocate(R_LEN);
+		limb* qd = ws.allocate(R_LEN);
+		reciprocal(d, d_len, x, PRECISION, ws);
+		// q = a * x / RADIX^(PRECISION + d_len - FRACTIONAL_LEN), keeping the first Q_LEN limbs
+		multiply_any(a, x, q, a_len, PRECISION + 1, ws);
+		helpers::set_to_zero(numerator, R_LEN);
+		for (std::size_t i = 0; i < a_len; ++i) { numerator[R_LEN - FRACTIONAL_LEN - a_len + i] = a[i]; }
+		multiply_any(q, d, qd, Q_LEN, d_len, ws);
+		while (compare(qd, R_LEN, numerator, R_LEN) > 0) {
+			subtract_from(qd, R_LEN, d, d_len);
+			subtract_from(q, Q_LEN, &ONE, 1);
+		}
+		// remainder
+		subtract_from(numerator, R_LEN, qd, R_LEN);
+		while (compare(numerator, R_LEN, d, d_len) >= 0) {
+			subtract_from(numerator, R_LEN, d, d_len);
+			add_into(q, Q_LEN, &ONE, 1, 0);
+		}
+		if (Q_LEN > len && !helpers::is_zero(q, Q_LEN - len)) {
 			throw std::overflow_error("Result of division is too large to compute!");
 		}
+		if (Q_LEN >= len) { helpers::copy_into(q + Q_LEN - len, result, len, len); }
+		else { helpers::copy_into(q, result + len - Q_LEN, Q_LEN, Q_LEN); }
 	}
 }
@@ -0,0 +1,282 @@
+/**
+ * big_integer.cpp
+ * BigInteger class implementation
+ *
+ * Copyright (c) 2012 Marshall Farrier
+ * license http://opensource.org/licenses/gpl-license.php GNU Public License
+ */
+
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+#include <utility>
+
+#include "big_integer.h"
+#include "array_arithmetic.h"
+
+// Constructors
+BigInteger::BigInteger() : negative(false) {}
+
+BigInteger::BigInteger(const long long& num) : negative(num < 0) {
+    // the magnitude of the most negative long long is computed unsigned
+    unsigned long long magnitude = negative ? 0ull - static_cast<unsigned long long>(num)
+            : static_cast<unsigned long long>(num);
+    for (; magnitude != 0; magnitude >>= array_arithmetic::LIMB_BITS) {
+        limbs.insert(limbs.begin(), static_cast<array_arithmetic::limb>(magnitude));
+    }
+}
+
+BigInteger::BigInteger(const std::string& str) : negative(false) {
+    const std::size_t START = !str.empty() && str[0] == '-' ? 1 : 0;
+    const std::size_t DIGITS = str.size() - START;
+    if (DIGITS == 0) { throw std::invalid_argument("Input can contain only decimal digits!"); }
+    limbs.resize(array_arithmetic::convert::power_of_ten_len(DIGITS));
+    array_arithmetic::convert::from_decimal_digits(str.c_str() + START, DIGITS, &limbs[0], limbs.size());
+    remove_leading_zeros();
+    negative = START == 1 && !limbs.empty();
+}
+
+BigInteger::BigInteger(const BigInteger& num) : limbs(num.limbs), negative(num.negative) {}
+
+BigInteger::BigInteger(BigInteger&& num) : limbs(std::move(num.limbs)), negative(num.negative) {
+    num.limbs.clear();
+    num.negative = false;
+}
+
+BigInteger& BigInteger::operator=(const BigInteger& num) {
+    limbs = num.limbs;
+    negative = num.negative;
+    return *this;
+}
+
+BigInteger& BigInteger::operator=(BigInteger&& num) {
+    if (this == &num) { return *this; }
+    limbs.swap(num.limbs);
+    negative = num.negative;
+    num.limbs.clear();
+    num.negative = false;
+    return *this;
+}
+
+// Conversions
+BigInteger BigInteger::from_real_number(const RealNumber& num) {
+    BigInteger result;
+    result.limbs.assign(num.value, num.value + num.array_size());
+    result.remove_leading_zeros();
+    return result;
+}
+
+RealNumber BigInteger::to_real_number(const std::size_t& fraction_limbs, const std::size_t& precision) const {
+    if (negative) { throw std::invalid_argument("RealNumber can't be negative!"); }
+    if (limbs.size() > RealNumber::INTEGER_DIGITS + fraction_limbs) {
+        throw std::invalid_argument("Integer part is too big for RealNumber!");
+    }
+    RealNumber result(precision);
+    // limb i of the magnitude goes to index ZEROS + i of the value array
+    const std::size_t ZEROS = RealNumber::INTEGER_DIGITS + fraction_limbs - limbs.size();
+    for (std::size_t i = ZEROS; i < result.array_size() && i - ZEROS < limbs.size(); ++i) {
+        result.value[i] = limbs[i - ZEROS];
+    }
+    return result;
+}
+
+std::string BigInteger::to_decimal_string() const {
+    if (limbs.empty()) { return "0"; }
+    // 9.63295986 ~ log10(2 ^ 32), so the magnitude is less than 10^DIGITS
+    const std::size_t DIGITS = static_cast<std::size_t>(limbs.size() * 9.63295986) + 1;
+    std::string digits(DIGITS, '0');
+    array_arithmetic::convert::to_decimal_digits(&limbs[0], limbs.size(), &digits[0], DIGITS);
+    std::string result = negative ? "-" : "";
+    result += digits.substr(digits.find_first_not_of('0'));
+    return result;
+}
+
+std::size_t BigInteger::size() const { return limbs.size(); }
+
+bool BigInteger::is_zero() const { return limbs.empty(); }
+
+bool BigInteger::is_negative() const { return negative; }
+
+// Arithmetic
+BigInteger BigInteger::operator-() const {
+    BigInteger result(*this);
+    result.negative = !limbs.empty() && !negative;
+    return result;
+}
+
+BigInteger& BigInteger::operator+=(const BigInteger& num) {
+    add(num, num.negative);
+    return *this;
+}
+
+BigInteger& BigInteger::operator-=(const BigInteger& num) {
+    add(num, !num.limbs.empty() && !num.negative);
+    return *this;
+}
+
+BigInteger& BigInteger::operator*=(const BigInteger& num) {
+    if (limbs.empty() || num.limbs.empty()) {
+        limbs.clear();
+        negative = false;
+        return *this;
+    }
+    // array_arithmetic::multiply() wants the longer operand first. x *= x squares
+    const BigInteger& longer = limbs.size() >= num.limbs.size() ? *this : num;
+    const BigInteger& shorter = limbs.size() >= num.limbs.size() ? num : *this;
+    std::vector<array_arithmetic::limb> product(limbs.size() + num.limbs.size() + 1);
+    array_arithmetic::multiply(&longer.limbs[0], &shorter.limbs[0], &product[0],
+            longer.limbs.size(), shorter.limbs.size());
+    limbs.swap(product);
+    negative = negative != num.negative;
+    remove_leading_zeros();
+    return *this;
+}
+
+BigInteger& BigInteger::operator*=(const array_arithmetic::limb& factor) {
+    array_arithmetic::double_limb carry = 0;
+    for (std::size_t i = limbs.size(); i > 0; --i) {
+        carry += static_cast<array_arithmetic::double_limb>(limbs[i - 1]) * factor;
+        limbs[i - 1] = static_cast<array_arithmetic::limb>(carry);
+        carry >>= array_arithmetic::LIMB_BITS;
+    }
+    if (carry != 0) { limbs.insert(limbs.begin(), static_cast<array_arithmetic::limb>(carry)); }
+    remove_leading_zeros();
+    return *this;
+}
+
+BigInteger& BigInteger::operator/=(const BigInteger& divisor) {
+    divide(divisor, this, 0);
+    return *this;
+}
+
+BigInteger& BigInteger::operator%=(const BigInteger& divisor) {
+    divide(divisor, 0, this);
+    return *this;
+}
+
+BigInteger operator+(const BigInteger& a, const BigInteger& b) {
+    BigInteger result(a);
+    return result += b;
+}
+
+BigInteger operator-(const BigInteger& a, const BigInteger& b) {
+    BigInteger result(a);
+    return result -= b;
+}
+
+BigInteger operator*(const BigInteger& a, const BigInteger& b) {
+    BigInteger result(a);
+    return result *= b;
+}
+
+BigInteger operator/(const BigInteger& a, const BigInteger& b) {
+    BigInteger result(a);
+    return result /= b;
+}
+
+BigInteger operator%(const BigInteger& a, const BigInteger& b) {
+    BigInteger result(a);
+    return result %= b;
+}
+
+// Comparison
+bool operator==(const BigInteger& num, const BigInteger& num_to_compare) {
+    return num.negative == num_to_compare.negative && num.limbs == num_to_compare.limbs;
+}
+
+bool operator!=(const BigInteger& num, const BigInteger& num_to_compare) {
+    return !(num == num_to_compare);
+}
+
+bool operator<(const BigInteger& num, const BigInteger& num_to_compare) {
+    if (num.negative != num_to_compare.negative) { return num.negative; }
+    const int COMPARISON = num.compare_magnitude(num_to_compare);
+    return num.negative ? COMPARISON > 0 : COMPARISON < 0;
+}
+
+bool operator<=(const BigInteger& num, const BigInteger& num_to_compare) {
+    return !(num_to_compare < num);
+}
+
+bool operator>(const BigInteger& num, const BigInteger& num_to_compare) {
+    return num_to_compare < num;
+}
+
+bool operator>=(const BigInteger& num, const BigInteger& num_to_compare) {
+    return !(num < num_to_compare);
+}
+
+// PRIVATE HELPER METHODS
+void BigInteger::remove_leading_zeros() {
+    std::size_t zeros = 0;
+    while (zeros < limbs.size() && limbs[zeros] == 0) { ++zeros; }
+    limbs.erase(limbs.begin(), limbs.begin() + zeros);
+    if (limbs.empty()) { negative = false; }
+}
+
+int BigInteger::compare_magnitude(const BigInteger& num) const {
+    if (limbs.size() != num.limbs.size()) { return limbs.size() < num.limbs.size() ? -1 : 1; }
+    if (limbs.empty()) { return 0; }
+    return array_arithmetic::helpers::compare(&limbs[0], &num.limbs[0], limbs.size());
+}
+
+void BigInteger::add(const BigInteger& num, const bool& num_negative) {
+    if (num.limbs.empty()) { return; }
+    if (limbs.empty()) {
+        limbs = num.limbs;
+        negative = num_negative;
+        return;
+    }
+    if (negative == num_negative) {
+        const BigInteger& longer = limbs.size() >= num.limbs.size() ? *this : num;
+        const BigInteger& shorter = limbs.size() >= num.limbs.size() ? num : *this;
+        std::vector<array_arithmetic::limb> sum(longer.limbs.size() + 1);
+        array_arithmetic::add(&longer.limbs[0], &shorter.limbs[0], &sum[0],
+                longer.limbs.size(), shorter.limbs.size());
+        limbs.swap(sum);
+    }
+    else if (compare_magnitude(num) >= 0) {
+        // *this has the larger magnitude and keeps its sign. The result may be 0,
+        // which remove_leading_zeros() makes non-negative
+        array_arithmetic::subtract(&limbs[0], &num.limbs[0], &limbs[0], limbs.size(), num.limbs.size());
+    }
+    else {
+        std::vector<array_arithmetic::limb> difference(num.limbs.size());
+        array_arithmetic::subtract(&num.limbs[0], &limbs[0], &difference[0], num.limbs.size(), limbs.size());
+        limbs.swap(difference);
+        negative = num_negative;
+    }
+    remove_leading_zeros();
+}
+
+void BigInteger::divide(const BigInteger& divisor, BigInteger* quotient, BigInteger* remainder) const {
+    if (divisor.limbs.empty()) { throw std::invalid_argument("Division by 0 is not allowed!"); }
+    const bool QUOTIENT_NEGATIVE = negative != divisor.negative;
+    const bool REMAINDER_NEGATIVE = negative;
+    BigInteger q;
+    if (compare_magnitude(divisor) >= 0) {
+        // integers are fixed-point numbers with only integer limbs, and both
+        // divisions truncate the quotient exactly
+        const std::size_t LEN = limbs.size();
+        std::vector<array_arithmetic::limb> padded_divisor(LEN, 0);
+        std::copy(divisor.limbs.begin(), divisor.limbs.end(), padded_divisor.end() - divisor.limbs.size());
+        q.limbs.resize(LEN);
+        if (LEN < array_arithmetic::newton_division_threshold) {
+            array_arithmetic::divide(&limbs[0], &padded_divisor[0], &q.limbs[0], LEN, LEN);
+        }
+        else { array_arithmetic::newton_divide(&limbs[0], &padded_divisor[0], &q.limbs[0], LEN, LEN); }
+        q.remove_leading_zeros();
+    }
+    if (remainder != 0) {
+        // |*this| - |q * divisor|, only when the remainder is wanted
+        BigInteger r(*this);
+        r.negative = false;
+        r.add(q * divisor, true);
+        *remainder = std::move(r);
+        remainder->negative = REMAINDER_NEGATIVE && !remainder->limbs.empty();
+    }
+    if (quotient != 0) {
+        *quotient = std::move(q);
+        quotient->negative = QUOTIENT_NEGATIVE && !quotient->limbs.empty();
+    }
+}
@@ -7,44 +7,380 @@
 //
 
 #include <iostream>
+#include <cmath>
+#include <cfloat>
+#include <stdexcept>
+#include <utility>
 #include "convergent_series.h"
+#include "big_integer.h"
+#include "real_task_graph.h"
+
+namespace {
+    /**
+     * babylonian_sqrt() iterations on result in place, with caller-owned
+     * temporaries of the same precision
+     */
+    void babylonian_iterations(RealNumber& result, const RealNumber& num, const std::size_t& iterations,
+                               const RealNumber& one_half, RealNumber& quotient) {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            div(quotient, num, result);
+            // added and halved in 1 pass
+            result = (result + quotient) * one_half;
+        }
+    }
+    /**
+     * 1 Newton step for y = 1 / sqrt(x) in place, with a caller-owned temporary,
+     * all of the same precision. correction is left with the absolute value of the
+     * change to y
+     */
+    void inv_sqrt_step(RealNumber& y, const RealNumber& x, const RealNumber& one,
+                       const RealNumber& one_half, RealNumber& correction) {
+        // x * y = sqrt(x) first: y * y could overflow or lose all its digits
+        correction = x * y;
+        correction *= y;
+        // RealNumber is unsigned, so the sign of 1 - x * y^2 picks the operation
+        const bool BELOW_ONE = correction < one;
+        if (BELOW_ONE) { correction = one - correction; }
+        else { correction -= one; }
+        correction = y * correction * one_half;
+        if (BELOW_ONE) { y += correction; }
+        else { y -= correction; }
+    }
+    /**
+     * inv_sqrt_step() until the correction equals 0 or stops getting smaller. From
+     * the second step on, the corrections shrink quadratically down to the rounding
+     * error of x * y^2, which for y > 1 can be well above the tolerance of equals()
+     */
+    void inv_sqrt_iterations(RealNumber& y, const RealNumber& x, const RealNumber& zero,
+                             const RealNumber& one, const RealNumber& one_half, RealNumber& correction,
+                             RealNumber& last_correction) {
+        inv_sqrt_step(y, x, one, one_half, correction);
+        do {
+            last_correction = correction;
+            inv_sqrt_step(y, x, one, one_half, correction);
+        } while (!correction.equals(zero) && correction < last_correction);
+    }
+    // 1 / sqrt(num) fits in the integer limb for larger num
+    const double MIN_INV_SQRT_ARGUMENT = std::ldexp(1.0, -2 * static_cast<int>(array_arithmetic::LIMB_BITS));
+    // fractional limbs that are 0 in a number of the size of estimate
+    std::size_t zero_limbs(const double& estimate) {
+        int exponent;
+        std::frexp(estimate, &exponent);
+        return exponent < 0 ? static_cast<std::size_t>(-exponent) / array_arithmetic::LIMB_BITS : 0;
+    }
+    /**
+     * working precision for the next step of a precision doubling iteration:
+     * each step doubles the good limbs. 1 guard limb is added
+     */
+    std::size_t next_limbs(std::size_t& good_limbs, const std::size_t& zero_limbs,
+                           const std::size_t& precision) {
+        good_limbs *= 2;
+        return zero_limbs + good_limbs + 1 < precision ? zero_limbs + good_limbs + 1 : precision;
+    }
+    /**
+     * Chudnovsky series: term k is (-1)^k (6k)! (13591409 + 545140134 k) /
+     * ((3k)! (k!)^3 640320^(3k)). The ratio of term k to term k - 1 is
+     * -p(k) (13591409 + 545140134 k) / (q(k) (13591409 + 545140134 (k - 1)))
+     * with p(k) = (6k - 5)(2k - 1)(6k - 1) and q(k) = k^3 640320^3 / 24
+     */
+    const array_arithmetic::double_limb CHUDNOVSKY_A = 13591409;
+    const array_arithmetic::double_limb CHUDNOVSKY_B = 545140134;
+    // 640320^3 / 24 = 640320^2 * 26680
+    const array_arithmetic::limb CHUDNOVSKY_C = 640320;
+    const array_arithmetic::limb CHUDNOVSKY_C_OVER_24 = 26680;
+    // about log2(640320^3 / 1728): each term adds 14.18 decimal digits
+    const double CHUDNOVSKY_BITS_PER_TERM = 47.11;
+    BigInteger chudnovsky_p(const std::size_t& k) {
+        if (k == 0) { return BigInteger(1); }
+        BigInteger result(static_cast<long long>(6 * k - 5));
+        result *= static_cast<array_arithmetic::limb>(2 * k - 1);
+        result *= static_cast<array_arithmetic::limb>(6 * k - 1);
+        return result;
+    }
+    BigInteger chudnovsky_q(const std::size_t& k) {
+        if (k == 0) { return BigInteger(1); }
+        BigInteger result(static_cast<long long>(k));
+        result *= static_cast<array_arithmetic::limb>(k);
+        result *= static_cast<array_arithmetic::limb>(k);
+        result *= CHUDNOVSKY_C_OVER_24;
+        result *= CHUDNOVSKY_C;
+        result *= CHUDNOVSKY_C;
+        return result;
+    }
+    // (-1)^k p(k) (13591409 + 545140134 k)
+    BigInteger chudnovsky_t(const std::size_t& k) {
+        BigInteger result(static_cast<long long>(CHUDNOVSKY_A + CHUDNOVSKY_B * k));
+        result *= chudnovsky_p(k);
+        return k % 2 == 1 ? -result : result;
+    }
+    // e = sum 1 / k!: p(k) = 1, q(0) = 1 and q(k) = k
+    BigInteger one(const std::size_t&) { return BigInteger(1); }
+    BigInteger factorial_q(const std::size_t& k) {
+        return BigInteger(k == 0 ? 1ll : static_cast<long long>(k));
+    }
+    /**
+     * binary splitting over the terms a <= k < b at the given depth of the tree
+     * The product P of the last subtree on each level isn't needed, so
+     * it is only computed if need_p is set
+     */
+    void split(const ConvergentSeries::SeriesTerms& terms, const std::size_t& a, const std::size_t& b,
+               BigInteger& p, BigInteger& q, BigInteger& t, const bool& need_p, const std::size_t& depth) {
+        if (b - a == 1) {
+            if (need_p) { p = terms.p(a); }
+            q = terms.q(a);
+            t = terms.t(a);
+            return;
+        }
+        const std::size_t MIDDLE = a + (b - a) / 2;
+        BigInteger p_right, q_right, t_right, p_product;
+        const bool CONCURRENT = depth < ConvergentSeries::splitting_serial_depth;
+        array_arithmetic::TaskGroup group;
+        // runs task concurrently above the serial depth
+        auto spawn = [&](const std::function<void()>& task) {
+            if (CONCURRENT) { group.run(task); }
+            else { task(); }
+        };
+        spawn([&] { split(terms, MIDDLE, b, p_right, q_right, t_right, need_p, depth + 1); });
+        split(terms, a, MIDDLE, p, q, t, true, depth + 1);
+        group.wait();
+        // T = T_left Q_right + P_left T_right, Q = Q_left Q_right, P = P_left P_right
+        spawn([&] { t *= q_right; });
+        spawn([&] { t_right *= p; });
+        spawn([&] { q *= q_right; });
+        if (need_p) { spawn([&] { p_product = p * p_right; }); }
+        group.wait();
+        t += t_right;
+        if (need_p) { p = std::move(p_product); }
+    }
+    /**
+     * terms for a precision of the given bits: the smallest n with
+     * log2(n!) > bits
+     */
+    std::size_t factorial_terms(const double& bits) {
+        std::size_t result = 1;
+        for (double log2_factorial = 0.0; log2_factorial <= bits; ++result) {
+            log2_factorial += std::log2(static_cast<double>(result + 1));
+        }
+        return result;
+    }
+}
+
+std::size_t ConvergentSeries::splitting_serial_depth = ConvergentSeries::SPLITTING_SERIAL_DEPTH;
+
+std::size_t ConvergentSeries::task_graph_threshold = ConvergentSeries::TASK_GRAPH_THRESHOLD;
 
 RealNumber ConvergentSeries::babylonian_sqrt(const RealNumber& num, const RealNumber& guess,
                                             const std::size_t& iterations) {
     RealNumber result = guess;
-    RealNumber two("2.0");
-    for (std::size_t i = 0; i < iterations; ++i) {
-        result = (result + (num / result)) / two;
+    const RealNumber one_half = RealNumber::from_double(0.5, num.get_precision());
+    RealNumber quotient(num.get_precision());
+    babylonian_iterations(result, num, iterations, one_half, quotient);
+    return result;
+}
+
+RealNumber ConvergentSeries::babylonian_sqrt(const RealNumber& num) {
+    const std::size_t PRECISION = num.get_precision();
+    RealNumber result(PRECISION);
+    if (num == result) { return result; }
+    // numbers below the range of double start from the smallest double
+    double estimate = num.to_double();
+    if (estimate < DBL_MIN) { estimate = DBL_MIN; }
+    const std::size_t ZERO_LIMBS = zero_limbs(estimate);
+    // the estimate is good to more than 1 limb
+    std::size_t good_limbs = 1;
+    std::size_t limbs = ZERO_LIMBS + 2 < PRECISION ? ZERO_LIMBS + 2 : PRECISION;
+    result = RealNumber::from_double(std::sqrt(estimate), limbs);
+    RealNumber one_half = RealNumber::from_double(0.5, limbs);
+    RealNumber working_num(limbs), quotient(limbs);
+    while (limbs < PRECISION) {
+        limbs = next_limbs(good_limbs, ZERO_LIMBS, PRECISION);
+        working_num = RealNumber(num, limbs);
+        result.set_precision(limbs);
+        one_half.set_precision(limbs);
+        babylonian_iterations(result, working_num, 1, one_half, quotient);
+    }
+    // steps at full precision while they still change the result
+    RealNumber previous(PRECISION);
+    one_half.set_precision(PRECISION);
+    do {
+        previous = result;
+        babylonian_iterations(result, num, 1, one_half, quotient);
+    } while (!result.equals(previous));
+    return result;
+}
+
+RealNumber ConvergentSeries::inv_sqrt(const RealNumber& num) {
+    const std::size_t PRECISION = num.get_precision();
+    double estimate = num.to_double();
+    if (!(estimate > MIN_INV_SQRT_ARGUMENT)) {
+        throw std::invalid_argument("Inverse square root is undefined or too big!");
+    }
+    const std::size_t ZERO_LIMBS = zero_limbs(estimate);
+    std::size_t good_limbs = 1;
+    std::size_t limbs = ZERO_LIMBS + 2 < PRECISION ? ZERO_LIMBS + 2 : PRECISION;
+    RealNumber result = RealNumber::from_double(1.0 / std::sqrt(estimate), limbs);
+    RealNumber zero(limbs);
+    RealNumber one = RealNumber::from_double(1.0, limbs);
+    RealNumber one_half = RealNumber::from_double(0.5, limbs);
+    RealNumber working_num(limbs), correction(limbs), last_correction(limbs);
+    while (limbs < PRECISION) {
+        limbs = next_limbs(good_limbs, ZERO_LIMBS, PRECISION);
+        working_num = RealNumber(num, limbs);
+        result.set_precision(limbs);
+        one.set_precision(limbs);
+        one_half.set_precision(limbs);
+        inv_sqrt_step(result, working_num, one, one_half, correction);
+    }
+    // steps at full precision while they still improve the result
+    zero.set_precision(PRECISION);
+    inv_sqrt_iterations(result, num, zero, one, one_half, correction, last_correction);
+    return result;
+}
+
+RealNumber ConvergentSeries::sqrt(const RealNumber& num) {
+    if (!(num.to_double() > MIN_INV_SQRT_ARGUMENT)) { return babylonian_sqrt(num); }
+    const RealNumber y = inv_sqrt(num);
+    RealNumber result(num * y);
+    /**
+     * Karp and Markstein: result += y * (num - result^2) / 2 removes the error
+     * that num * y gets from the error of y, multiplied by num. For num <= 1 that
+     * error is within the last limb already, while the rounding error of the
+     * correction would be multiplied by y >= 1
+     */
+    const RealNumber one = RealNumber::from_double(1.0, num.get_precision());
+    if (num <= one) { return result; }
+    const RealNumber one_half = RealNumber::from_double(0.5, num.get_precision());
+    RealNumber error(result * result);
+    if (error < num) {
+        error = num - error;
+        result += y * error * one_half;
+    }
+    else {
+        error -= num;
+        result -= y * error * one_half;
     }
     return result;
 }
 
 RealNumber ConvergentSeries::gauss_legendre_pi(const std::size_t& pi_iterations,
                                                const std::size_t& sqrt_iterations, const RealNumber& sqrt_two) {
-    RealNumber a("1.0");
-    RealNumber a_next;
-    RealNumber b = RealNumber("1.0") / sqrt_two;
-    RealNumber b_next;
-    RealNumber t("0.25");
-    RealNumber t_next;
-    RealNumber p("1.0");
-    RealNumber p_next;
-    RealNumber tmp1, tmp2;
+    // all calculations use the precision of sqrt_two
+    const std::size_t PRECISION = sqrt_two.get_precision();
+    RealNumber a("1.0", PRECISION);
+    RealNumber a_next(PRECISION);
+    RealNumber b = a / sqrt_two;
+    RealNumber t("0.25", PRECISION);
+    RealNumber p("1.0", PRECISION);
+    RealNumber p_next(PRECISION);
+    RealNumber tmp1(PRECISION), tmp2(PRECISION), difference(PRECISION);
     
-    const RealNumber one_half("0.5");
-    const RealNumber two("2.0");
+    const RealNumber one_half("0.5", PRECISION);
+    const RealNumber four("4.0", PRECISION);
+    // 1 iteration, in which sqrt(a * b) runs concurrently with the update of t
+    RealTaskGraph iteration;
+    const RealTaskGraph::Node MEAN = iteration.assign(a_next, (a + b) * one_half);
+    const RealTaskGraph::Node PRODUCT = iteration.assign(tmp1, a * b);
+    // b_next = sqrt(a * b) with a_next as the guess
+    iteration.add([&]() {
+        b = a_next;
+        babylonian_iterations(b, tmp1, sqrt_iterations, one_half, tmp2);
+    }, {MEAN, PRODUCT});
+    const RealTaskGraph::Node DIFFERENCE = iteration.assign(difference, a - a_next, {MEAN});
+    iteration.assign(p_next, p + p);
+    iteration.assign(t, t - p * (difference * difference), {DIFFERENCE});
+    const bool CONCURRENT = PRECISION >= task_graph_threshold;
+    // all temporaries and the graph exist before the loop, which doesn't allocate
+    // unless it runs concurrently
+    for (std::size_t i = 0; i < pi_iterations; ++i) {
+        iteration.run(CONCURRENT);
+        a = a_next;
+        p = p_next;
+    }
+    tmp1 = a + b;
+    tmp2 = four * t;
+    return tmp1 * tmp1 / tmp2;
+}
+
+RealNumber ConvergentSeries::gauss_legendre_pi(const std::size_t& pi_iterations, const std::size_t& limbs) {
+    const RealNumber zero(limbs);
+    const RealNumber one = RealNumber::from_double(1.0, limbs);
+    const RealNumber one_half = RealNumber::from_double(0.5, limbs);
+    const RealNumber four = RealNumber::from_double(4.0, limbs);
+    RealNumber a(one);
+    RealNumber a_next(limbs);
+    // from here on, y approximates 1 / sqrt(a * b) of the iteration before
+    RealNumber y = inv_sqrt(RealNumber::from_double(2.0, limbs));
+    RealNumber b(y);
+    RealNumber t = RealNumber::from_double(0.25, limbs);
+    RealNumber p(one);
+    RealNumber p_next(limbs);
+    RealNumber tmp1(limbs), tmp2(limbs), tmp3(limbs), difference(limbs);
+    // 1 iteration, in which sqrt(a * b) runs concurrently with the update of t
+    RealTaskGraph iteration;
+    const RealTaskGraph::Node MEAN = iteration.assign(a_next, (a + b) * one_half);
+    const RealTaskGraph::Node PRODUCT = iteration.assign(tmp1, a * b);
+    // b_next = sqrt(a * b) = a * b / sqrt(a * b)
+    iteration.add([&]() {
+        inv_sqrt_iterations(y, tmp1, zero, one, one_half, tmp2, tmp3);
+        b = tmp1 * y;
+    }, {MEAN, PRODUCT});
+    const RealTaskGraph::Node DIFFERENCE = iteration.assign(difference, a - a_next, {MEAN});
+    iteration.assign(p_next, p + p);
+    iteration.assign(t, t - p * (difference * difference), {DIFFERENCE});
+    const bool CONCURRENT = limbs >= task_graph_threshold;
+    // all temporaries and the graph exist before the loop, which doesn't allocate
+    // unless it runs concurrently
     for (std::size_t i = 0; i < pi_iterations; ++i) {
-        a_next = (a + b) * one_half;
-        b_next = babylonian_sqrt(a * b, a_next, sqrt_iterations);
-        tmp1 = a - a_next;
-        t_next = t - p * tmp1 * tmp1;
-        p_next = two * p;
+        iteration.run(CONCURRENT);
         a = a_next;
-        b = b_next;
-        t = t_next;
         p = p_next;
     }
     tmp1 = a + b;
-    tmp2 = RealNumber("4.0") * t;
+    tmp2 = four * t;
     return tmp1 * tmp1 / tmp2;
 }
+
+RealNumber ConvergentSeries::chudnovsky_pi(const std::size_t& limbs) {
+    const std::size_t TERMS = static_cast<std::size_t>(limbs * array_arithmetic::LIMB_BITS /
+            CHUDNOVSKY_BITS_PER_TERM) + 2;
+    SeriesTerms terms;
+    terms.p = chudnovsky_p;
+    terms.q = chudnovsky_q;
+    terms.t = chudnovsky_t;
+    BigInteger q, t;
+    binary_splitting(terms, TERMS, q, t);
+    /**
+     * pi = 426880 sqrt(10005) Q / T. Q and T are scaled by the same power of RADIX,
+     * so that T is a fraction with a nonzero first limb. Q is about 2^(-24) T, and
+     * 2 guard limbs keep its leading limbs
+     */
+    const std::size_t WORKING_LIMBS = limbs + 2;
+    RealNumber result = q.to_real_number(t.size(), WORKING_LIMBS);
+    result = sqrt(RealNumber::from_double(10005.0, WORKING_LIMBS)) * result;
+    result = RealNumber::from_double(426880.0, WORKING_LIMBS) * result;
+    result /= t.to_real_number(t.size(), WORKING_LIMBS);
+    result.set_precision(limbs);
+    return result;
+}
+
+void ConvergentSeries::binary_splitting(const SeriesTerms& terms, const std::size_t& n, BigInteger& q,
+                                        BigInteger& t) {
+    BigInteger p;
+    split(terms, 0, n, p, q, t, false, 0);
+}
+
+RealNumber ConvergentSeries::e(const std::size_t& limbs) {
+    // 1 guard limb for the division
+    const std::size_t WORKING_LIMBS = limbs + 1;
+    SeriesTerms terms;
+    terms.p = one;
+    terms.q = factorial_q;
+    terms.t = one;
+    BigInteger q, t;
+    binary_splitting(terms, factorial_terms(static_cast<double>(WORKING_LIMBS * array_arithmetic::LIMB_BITS)),
+                     q, t);
+    // e = T / Q, both scaled so that T is a fraction
+    RealNumber result = t.to_real_number(t.size(), WORKING_LIMBS) / q.to_real_number(t.size(), WORKING_LIMBS);
+    result.set_precision(limbs);
+    return result;
+}
@@ -2,11 +2,17 @@
  * Executable using real_number.h and convergent_series.h
  * to find pi to a high degree of accuracy
  *
+ * find_pi [--algorithm chudnovsky|gauss-legendre] [--digits N]
+ * prints pi to N decimal digits (default RealNumber::DECIMAL_PRECISION) with
+ * the given algorithm (default chudnovsky). Without options it runs the
+ * original demonstration of RealNumber.
+ *
  * Created by Marshall Farrier on 5/26/12.
  * Copyright (c) 2012 Marshall Farrier
  * license http://opensource.org/licenses/gpl-license.php GNU Public License
  */
 
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <stdexcept>
@@ -18,8 +24,56 @@
 
 using namespace std;
 
+namespace {
+	void print_usage(const char* program) {
+		cerr << "usage: " << program << " [--algorithm chudnovsky|gauss-legendre] [--digits N]" << endl;
+	}
+
+	// Gauss-Legendre iterations for the given digits: each iteration doubles them
+	size_t gauss_legendre_iterations(const size_t& digits) {
+		size_t iterations = 1;
+		while ((static_cast<size_t>(1) << iterations) < digits) { ++iterations; }
+		return iterations;
+	}
+
+	int print_pi(const string& algorithm, const size_t& digits) {
+		// 1 guard limb, since the last limb of the result can be off
+		const size_t LIMBS = RealNumber::precision_for_digits(digits) + 1;
+		RealNumber pi;
+		if (algorithm == "chudnovsky") { pi = ConvergentSeries::chudnovsky_pi(LIMBS); }
+		else { pi = ConvergentSeries::gauss_legendre_pi(gauss_legendre_iterations(digits), LIMBS); }
+		// "3." and the digits
+		cout << pi.to_decimal_string().substr(0, digits + 2) << endl;
+		return 0;
+	}
+}
+
 int main(int argc, const char * argv[])
 {
+	if (argc > 1) {
+		string algorithm = "chudnovsky";
+		size_t digits = RealNumber::DECIMAL_PRECISION;
+		for (int i = 1; i < argc; ++i) {
+			const string option = argv[i];
+			if (i + 1 == argc) {
+				print_usage(argv[0]);
+				return 1;
+			}
+			const string argument = argv[++i];
+			if (option == "--algorithm" && (argument == "chudnovsky" || argument == "gauss-legendre")) {
+				algorithm = argument;
+			}
+			else if (option == "--digits" && argument.find_first_not_of("0123456789") == string::npos
+					&& strtoul(argument.c_str(), 0, 10) > 0) {
+				digits = strtoul(argument.c_str(), 0, 10);
+			}
+			else {
+				print_usage(argv[0]);
+				return 1;
+			}
+		}
+		return print_pi(algorithm, digits);
+	}
 	//karatsuba::say_hello();
 
 	string str = "1.0";
@@ -46,11 +100,10 @@ int main(int argc, const char * argv[])
 	RealNumber guess("1.4");
 	int iterations = 10;
 	
-	RealNumber sqrt_two = ConvergentSeries::babylonian_sqrt(num, guess, iterations);
+	RealNumber sqrt_two = ConvergentSeries::sqrt(num);
 	
 	cout << "Square root of 2 is " << sqrt_two.to_decimal_string() << endl;
-	cout << "or: " << ConvergentSeries::babylonian_sqrt(RealNumber("2.0"), RealNumber("1.4"), 
-																											iterations).to_decimal_string() << endl;
+	cout << "or: " << ConvergentSeries::babylonian_sqrt(num, guess, iterations).to_decimal_string() << endl;
 	
 	RealNumber pi = ConvergentSeries::gauss_legendre_pi(6, 10, sqrt_two);
 	cout << "Pi is\n" << pi.to_decimal_string() << endl;
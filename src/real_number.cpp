@@ -11,140 +11,204 @@
 #include <string>
 #include <stdexcept>
 #include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
 
 #include "real_number.h"
 #include "array_arithmetic.h"
 
 // Constructors and destructor
-RealNumber::RealNumber() { init(); }
+RealNumber::RealNumber() : precision(PRECISION) { init(); }
 
-RealNumber::RealNumber(const std::string& str) {
+RealNumber::RealNumber(const std::size_t& limbs) : precision(limbs) { init(); }
+
+RealNumber::RealNumber(const std::string& str) : precision(PRECISION) {
     init();
     assign_value(str);
 }
 
-RealNumber::RealNumber(const RealNumber& num) {
-    value = new unsigned char[ARRAY_SIZE];
-    for (unsigned int i = 0; i < ARRAY_SIZE; ++i) {
+RealNumber::RealNumber(const std::string& str, const std::size_t& limbs) : precision(limbs) {
+    init();
+    assign_value(str);
+}
+
+RealNumber::RealNumber(const RealNumber& num) : precision(num.precision) {
+    allocate();
+    for (std::size_t i = 0; i < array_size(); ++i) {
         value[i] = num.value[i];
     }
 }
 
+RealNumber::RealNumber(RealNumber&& num) : precision(num.precision) {
+    if (num.is_inline()) {
+        allocate();
+        for (std::size_t i = 0; i < array_size(); ++i) {
+            value[i] = num.value[i];
+        }
+        return;
+    }
+    value = num.value;
+    num.reset_moved();
+}
+
+RealNumber::RealNumber(const RealNumber& num, const std::size_t& limbs) : precision(limbs) {
+    allocate();
+    std::size_t source_len = num.array_size() < array_size() ? num.array_size() : array_size();
+    array_arithmetic::helpers::copy_into(num.value, value, source_len, array_size());
+}
+
 RealNumber::~RealNumber() {
-    delete[] value;
+    release();
 }
 
 // public methods
+std::size_t RealNumber::precision_for_digits(const std::size_t& decimal_digits) {
+    std::size_t result = 1;
+    while (static_cast<std::size_t>(result * 9.63295986) < decimal_digits) { ++result; }
+    return result;
+}
+
+std::size_t RealNumber::get_precision() const { return precision; }
+
+std::size_t RealNumber::get_decimal_precision() const {
+    return static_cast<std::size_t>(precision * 9.63295986);
+}
+
+double RealNumber::to_double() const {
+    std::size_t i = 0;
+    while (i < array_size() && value[i] == 0) { ++i; }
+    if (i == array_size()) { return 0.0; }
+    // the leading 64 bits, starting with the leading 1, and the power of 2 of their last bit
+    array_arithmetic::double_limb bits = static_cast<array_arithmetic::double_limb>(value[i])
+            << array_arithmetic::LIMB_BITS;
+    if (i + 1 < array_size()) { bits |= value[i + 1]; }
+    int exponent = (static_cast<int>(INTEGER_DIGITS) - 2 - static_cast<int>(i)) *
+            static_cast<int>(array_arithmetic::LIMB_BITS);
+    std::size_t shift = 0;
+    while ((bits >> 63) == 0) {
+        bits <<= 1;
+        ++shift;
+    }
+    if (shift > 0 && i + 2 < array_size()) { bits |= value[i + 2] >> (array_arithmetic::LIMB_BITS - shift); }
+    exponent -= static_cast<int>(shift);
+    // truncated to the 53 bits of a double, so the conversion is exact
+    bits &= ~static_cast<array_arithmetic::double_limb>(0) << (64 - DBL_MANT_DIG);
+    return std::ldexp(static_cast<double>(bits), exponent);
+}
+
+RealNumber RealNumber::from_double(const double& num, const std::size_t& limbs) {
+    // value of the integer part in units of its first limb
+    double remainder = std::ldexp(num, -(static_cast<int>(INTEGER_DIGITS) - 1) *
+            static_cast<int>(array_arithmetic::LIMB_BITS));
+    if (!(remainder >= 0.0 && remainder < static_cast<double>(array_arithmetic::RADIX))) {
+        throw std::invalid_argument("Double out of range!");
+    }
+    RealNumber result(limbs);
+    // each step is exact, since it only removes and shifts bits
+    for (std::size_t i = 0; i < result.array_size() && remainder != 0.0; ++i) {
+        double digit = std::floor(remainder);
+        result.value[i] = static_cast<array_arithmetic::limb>(digit);
+        remainder = std::ldexp(remainder - digit, static_cast<int>(array_arithmetic::LIMB_BITS));
+    }
+    return result;
+}
+
+RealNumber RealNumber::from_limbs(const array_arithmetic::limb* arr, const std::size_t& len,
+        const std::size_t& limbs) {
+    RealNumber result(limbs);
+    const std::size_t COPIED = len < result.array_size() ? len : result.array_size();
+    for (std::size_t i = 0; i < COPIED; ++i) { result.value[i] = arr[i]; }
+    return result;
+}
+
+void RealNumber::set_precision(const std::size_t& limbs) {
+    if (limbs == precision) { return; }
+    *this = RealNumber(*this, limbs);
+}
+
+std::size_t RealNumber::scratch_limbs(const std::size_t& limbs) {
+    array_arithmetic::Workspace ws;
+    RealNumber one("1.0", limbs);
+    RealNumber three("3.0", limbs);
+    RealNumber result(limbs);
+    one.multiply(three, result, ws);
+    three.square(result, ws);
+    one.divide(three, result, ws);
+    result.to_decimal_string(ws);
+    return ws.get_peak();
+}
+
 std::string RealNumber::to_decimal_string() const {
-    std::stringstream result;
-    result << get_integer_part() << '.';
-    // make a copy of value because we will be changing it
-    unsigned char* fractional_part = new unsigned char[PRECISION];
-    std::size_t i;
-    for (i = 0; i < PRECISION; ++i) { fractional_part[i] = value[i + INTEGER_DIGITS]; }
-		for (i = 0; i < DECIMAL_PRECISION; ++i) { 
-			result << (int)(array_arithmetic::convert::helpers::times_ten(fractional_part, PRECISION)); 
-		}    
-    delete[] fractional_part;
-    return result.str();
+    return to_decimal_string(array_arithmetic::Workspace::local());
 }
 
 RealNumber& RealNumber::operator=(const RealNumber& num) {
     if (this == &num) { return *this; }
-    for (std::size_t i = 0; i < ARRAY_SIZE; ++i) {
+    if (precision != num.precision) {
+        release();
+        precision = num.precision;
+        allocate();
+    }
+    for (std::size_t i = 0; i < array_size(); ++i) {
         this->value[i] = num.value[i];
     }
     return *this;
 }
 
-bool RealNumber::operator>(const RealNumber& num_to_compare) const {
-    for (std::size_t i = 0; i < ARRAY_SIZE; ++i) {
-        if (this->value[i] > num_to_compare.value[i]) { return true; }
-        else if (this->value[i] < num_to_compare.value[i]) { return false; }
+RealNumber& RealNumber::operator=(RealNumber&& num) {
+    if (this == &num) { return *this; }
+    // inline storage can't be handed over, so it is copied
+    if (num.is_inline()) { return *this = num; }
+    if (is_inline()) {
+        precision = num.precision;
+        value = num.value;
+        num.reset_moved();
     }
-    return false;
-}
-
-bool RealNumber::operator>=(const RealNumber& num_to_compare) const {
-    for (std::size_t i = 0; i < ARRAY_SIZE; ++i) {
-        if (this->value[i] > num_to_compare.value[i]) { return true; }
-        else if (this->value[i] < num_to_compare.value[i]) { return false; }
+    else {
+        // num takes over our heap storage and frees it when it is destroyed
+        std::swap(precision, num.precision);
+        std::swap(value, num.value);
     }
-    return true;
+    return *this;
 }
 
-bool RealNumber::operator<(const RealNumber& num_to_compare) const {
-    for (std::size_t i = 0; i < ARRAY_SIZE; ++i) {
-        if (this->value[i] < num_to_compare.value[i]) { return true; }
-        else if (this->value[i] > num_to_compare.value[i]) { return false; }
-    }
-    return false;
+bool operator>(const RealNumber& num, const RealNumber& num_to_compare) {
+    return num.compare(num_to_compare) > 0;
 }
 
-bool RealNumber::operator<=(const RealNumber& num_to_compare) const {
-    for (std::size_t i = 0; i < ARRAY_SIZE; ++i) {
-        if (this->value[i] < num_to_compare.value[i]) { return true; }
-        else if (this->value[i] > num_to_compare.value[i]) { return false; }
-    }
-    return true;
+bool operator>=(const RealNumber& num, const RealNumber& num_to_compare) {
+    return num.compare(num_to_compare) >= 0;
 }
 
-bool RealNumber::operator!=(const RealNumber& num_to_compare) const {
-    for (std::size_t i = 0; i < ARRAY_SIZE; ++i) {
-        if (this->value[i] != num_to_compare.value[i]) { return true; }
-    }
-    return false;
+bool operator<(const RealNumber& num, const RealNumber& num_to_compare) {
+    return num.compare(num_to_compare) < 0;
 }
 
-bool RealNumber::operator==(const RealNumber& num_to_compare) const {
-    return !(*this != num_to_compare);
+bool operator<=(const RealNumber& num, const RealNumber& num_to_compare) {
+    return num.compare(num_to_compare) <= 0;
 }
 
-bool RealNumber::equals(const RealNumber& num_to_compare) const {
-	// get the real number against which to measure difference
-	std::size_t total_bits = ARRAY_SIZE * 8;
-	std::size_t first_bit_to_set = total_bits - BITS_FOR_EQUALITY;
-	RealNumber max_diff;
-	for (std::size_t i = first_bit_to_set; i < total_bits; ++i) {
-		array_arithmetic::bits::set(max_diff.value, i);
-	}
-	return this->difference(num_to_compare) <= max_diff;
+bool operator!=(const RealNumber& num, const RealNumber& num_to_compare) {
+    return num.compare(num_to_compare) != 0;
 }
 
-RealNumber RealNumber::operator+(const RealNumber& num_to_add) const {
-    RealNumber result = RealNumber();
-    int carry = 0, tmp_sum = 0;
-    for (int i = ARRAY_SIZE - 1; i >= 0; --i) {
-        tmp_sum = carry + this->value[i] + num_to_add.value[i];
-        result.value[i] = tmp_sum % array_arithmetic::RADIX;
-        carry = tmp_sum / array_arithmetic::RADIX;
-    }
-    return result;
+bool operator==(const RealNumber& num, const RealNumber& num_to_compare) {
+    return !(num != num_to_compare);
 }
 
-RealNumber RealNumber::operator-(const RealNumber& num_to_subtract) const {
-    RealNumber result = RealNumber();
-    array_arithmetic::subtract(this->value, num_to_subtract.value, result.value, ARRAY_SIZE);
-    return result;
-}
+// bound to a const reference in equals()
+const array_arithmetic::limb RealNumber::EQUALITY_TOLERANCE;
 
-RealNumber RealNumber::operator*(const RealNumber& multiplier) const {
-	unsigned char* result_arr = new unsigned char[2 * ARRAY_SIZE + 1];
-	RealNumber result;
-	array_arithmetic::school_multiply(this->value, multiplier.value, result_arr, ARRAY_SIZE,
-			ARRAY_SIZE);
-	std::size_t offset = INTEGER_DIGITS + 1;
-	for (std::size_t i = 0; i < ARRAY_SIZE; ++i) {
-		result.value[i] = result_arr[i + offset];
-	}
-	delete[] result_arr;
-	return result;
+bool RealNumber::equals(const RealNumber& num_to_compare) const {
+	// the tolerance is in units of the last limb of the less precise number
+	return array_arithmetic::helpers::within_ulps(value, array_size(), num_to_compare.value,
+			num_to_compare.array_size(), EQUALITY_TOLERANCE);
 }
 
-RealNumber RealNumber::operator/(const RealNumber& divisor) const {
-	RealNumber result;
-	array_arithmetic::divide(this->value, divisor.value, result.value, ARRAY_SIZE, INTEGER_DIGITS);
-	return result;
+RealNumber& RealNumber::operator/=(const RealNumber& divisor) {
+	div(*this, *this, divisor);
+	return *this;
 }
 
 RealNumber RealNumber::difference(const RealNumber &num_to_subtract) const {
@@ -168,33 +232,200 @@ void RealNumber::assign_value(const std::string& str) {
     }
     set_integer_part(integer_part);
 		std::size_t fractional_digits_len = str.size() - dot_position - 1;
-    unsigned char* decimal_digits = array_arithmetic::convert::helpers::to_digit_array(str.substr(dot_position + 1));
-    for (i = INTEGER_DIGITS; i < ARRAY_SIZE; ++i) {
-        value[i] = array_arithmetic::convert::helpers::times_radix(decimal_digits, fractional_digits_len);
+    // the fraction is floor(digits * RADIX^precision / 10^fractional_digits_len)
+    const std::size_t DIGITS_LEN = array_arithmetic::convert::power_of_ten_len(fractional_digits_len);
+    const std::size_t LEN = DIGITS_LEN > precision ? DIGITS_LEN : precision;
+    array_arithmetic::Workspace& ws = array_arithmetic::Workspace::local();
+    array_arithmetic::Workspace::Frame frame(ws);
+    array_arithmetic::limb* digits_value = ws.allocate(LEN);
+    array_arithmetic::limb* power = ws.allocate(LEN);
+    array_arithmetic::limb* fraction = ws.allocate(LEN);
+    array_arithmetic::helpers::set_to_zero(digits_value, LEN - DIGITS_LEN);
+    array_arithmetic::convert::from_decimal_digits(str.data() + dot_position + 1, fractional_digits_len,
+            digits_value + LEN - DIGITS_LEN, DIGITS_LEN, ws);
+    array_arithmetic::convert::power_of_ten(fractional_digits_len, power, LEN, ws);
+    // precision fractional places in the quotient
+    if (LEN >= array_arithmetic::newton_division_threshold) {
+        array_arithmetic::newton_divide(digits_value, power, fraction, LEN, LEN - precision, ws);
     }
-    delete[] decimal_digits;
+    else {
+        array_arithmetic::divide(digits_value, power, fraction, LEN, LEN - precision, ws);
+    }
+    for (i = 0; i < precision; ++i) { value[i + INTEGER_DIGITS] = fraction[i + LEN - precision]; }
 }
 
 // private methods
 void RealNumber::init() {
-    value = new unsigned char[ARRAY_SIZE];
-    for (std::size_t i = 0; i < ARRAY_SIZE; ++i) {
+    allocate();
+    for (std::size_t i = 0; i < array_size(); ++i) {
         value[i] = 0;
     }
 }
 
+void RealNumber::allocate() {
+    if (array_size() <= INLINE_LIMBS) { value = inline_value; }
+    else { value = new array_arithmetic::limb[array_size()]; }
+}
+
+void RealNumber::release() {
+    if (!is_inline()) { delete[] value; }
+}
+
+bool RealNumber::is_inline() const { return value == inline_value; }
+
+void RealNumber::reset_moved() {
+    precision = 0;
+    value = inline_value;
+    value[0] = 0;
+}
+
+std::size_t RealNumber::array_size() const { return INTEGER_DIGITS + precision; }
+
 void RealNumber::set_integer_part(const int& integer_part) {
-    unsigned int tmp = integer_part;
-    for (int i = INTEGER_DIGITS - 1; i >= 0; --i) {
-        value[i] = tmp % array_arithmetic::RADIX;
-        tmp /= array_arithmetic::RADIX;
-    }
+    array_arithmetic::convert::from_int(integer_part, value, INTEGER_DIGITS);
+}
+
+RealNumber RealNumber::square() const {
+	RealNumber result(precision);
+	square(result, array_arithmetic::Workspace::local());
+	return result;
 }
 
 unsigned int RealNumber::get_integer_part() const {
-    unsigned int result = 0;
-    for (std::size_t i = 0; i < INTEGER_DIGITS; ++i) {
-        result = result * array_arithmetic::RADIX + value[i];
+    return array_arithmetic::convert::to_int(value, INTEGER_DIGITS);
+}
+
+void RealNumber::multiply(const RealNumber& multiplier, RealNumber& result,
+		array_arithmetic::Workspace& ws) const {
+	multiply_limbs(value, multiplier.value, result.value, precision, ws);
+}
+
+void RealNumber::square(RealNumber& result, array_arithmetic::Workspace& ws) const {
+	multiply_limbs(value, value, result.value, precision, ws);
+}
+
+void RealNumber::divide(const RealNumber& divisor, RealNumber& result,
+		array_arithmetic::Workspace& ws) const {
+	divide_limbs(value, divisor.value, result.value, precision, ws);
+}
+
+void RealNumber::multiply_limbs(const array_arithmetic::limb* a, const array_arithmetic::limb* b,
+		array_arithmetic::limb* result, const std::size_t& precision, array_arithmetic::Workspace& ws) {
+	const std::size_t ARRAY_SIZE = INTEGER_DIGITS + precision;
+	std::size_t offset = INTEGER_DIGITS + 1;
+	array_arithmetic::Workspace::Frame frame(ws);
+	array_arithmetic::limb* result_arr;
+	if (a == b) {
+		result_arr = ws.allocate(2 * ARRAY_SIZE + 1);
+		array_arithmetic::square(a, result_arr, ARRAY_SIZE, ws);
+	}
+	else {
+		// only the limbs up to the last fractional limb are needed, and the short
+		// product is off by at most 1 in the last of them
+		result_arr = ws.allocate(ARRAY_SIZE + offset);
+		array_arithmetic::short_multiply(a, b, result_arr, ARRAY_SIZE, ARRAY_SIZE + offset, ws);
+	}
+	for (std::size_t i = 0; i < ARRAY_SIZE; ++i) {
+		result[i] = result_arr[i + offset];
+	}
+}
+
+void RealNumber::divide_limbs(const array_arithmetic::limb* a, const array_arithmetic::limb* b,
+		array_arithmetic::limb* result, const std::size_t& precision, array_arithmetic::Workspace& ws) {
+	const std::size_t ARRAY_SIZE = INTEGER_DIGITS + precision;
+	array_arithmetic::Workspace::Frame frame(ws);
+	// the division functions overwrite result before they have read the operands
+	bool is_alias = result == a || result == b;
+	array_arithmetic::limb* quotient = is_alias ? ws.allocate(ARRAY_SIZE) : result;
+	if (ARRAY_SIZE >= array_arithmetic::newton_division_threshold) {
+		array_arithmetic::newton_divide(a, b, quotient, ARRAY_SIZE, INTEGER_DIGITS, ws);
+	}
+	else {
+		array_arithmetic::divide(a, b, quotient, ARRAY_SIZE, INTEGER_DIGITS, ws);
+	}
+	if (is_alias) { array_arithmetic::helpers::copy_into(quotient, result, ARRAY_SIZE, ARRAY_SIZE); }
+}
+
+const array_arithmetic::limb* RealNumber::operand_limbs(const RealNumber& num, const std::size_t& limbs,
+		array_arithmetic::Workspace& ws) {
+	if (num.precision == limbs) { return num.value; }
+	array_arithmetic::limb* result = ws.allocate(INTEGER_DIGITS + limbs);
+	array_arithmetic::helpers::copy_into(num.value, result, num.array_size(), INTEGER_DIGITS + limbs);
+	return result;
+}
+
+bool RealNumber::single_limb(const RealNumber& num, array_arithmetic::limb& factor, std::size_t& index) {
+	factor = 0;
+	index = 0;
+	for (std::size_t i = 0; i < num.array_size(); ++i) {
+		if (num.value[i] == 0) { continue; }
+		// a second nonzero limb, which for most numbers is found right away
+		if (factor != 0) { return false; }
+		factor = num.value[i];
+		index = i;
+	}
+	return true;
+}
+
+std::string RealNumber::to_decimal_string(array_arithmetic::Workspace& ws) const {
+    std::stringstream integer_part;
+    integer_part << get_integer_part() << '.';
+    std::string result = integer_part.str();
+    const std::size_t DECIMAL_DIGITS = get_decimal_precision();
+    if (DECIMAL_DIGITS == 0) { return result; }
+    // the digits are those of the integer part of fractional part * 10^DECIMAL_DIGITS
+    const std::size_t POWER_LEN = array_arithmetic::convert::power_of_ten_len(DECIMAL_DIGITS);
+    const std::size_t PRODUCT_LEN = POWER_LEN + precision + 1;
+    array_arithmetic::Workspace::Frame frame(ws);
+    array_arithmetic::limb* power = ws.allocate(POWER_LEN);
+    array_arithmetic::limb* product = ws.allocate(PRODUCT_LEN);
+    char* digits = reinterpret_cast<char*>(ws.allocate(DECIMAL_DIGITS / sizeof(array_arithmetic::limb) + 1));
+    array_arithmetic::convert::power_of_ten(DECIMAL_DIGITS, power, POWER_LEN, ws);
+    if (precision <= POWER_LEN) {
+        array_arithmetic::multiply(power, value + INTEGER_DIGITS, product, POWER_LEN, precision, ws);
+    }
+    else {
+        array_arithmetic::multiply(value + INTEGER_DIGITS, power, product, precision, POWER_LEN, ws);
     }
+    array_arithmetic::convert::to_decimal_digits(product, POWER_LEN + 1, digits, DECIMAL_DIGITS, ws);
+    result.append(digits, DECIMAL_DIGITS);
     return result;
 }
+
+int RealNumber::compare(const RealNumber& num_to_compare) const {
+    const std::size_t COMMON_LEN = array_size() < num_to_compare.array_size() ? array_size() :
+            num_to_compare.array_size();
+    int result = array_arithmetic::helpers::compare(this->value, num_to_compare.value, COMMON_LEN);
+    if (result != 0) { return result; }
+    // any nonzero limb beyond the common precision decides the comparison
+    if (!array_arithmetic::helpers::is_zero(this->value + COMMON_LEN, array_size() - COMMON_LEN)) {
+        return 1;
+    }
+    if (!array_arithmetic::helpers::is_zero(num_to_compare.value + COMMON_LEN,
+            num_to_compare.array_size() - COMMON_LEN)) {
+        return -1;
+    }
+    return 0;
+}
+
+// arithmetic into a caller-owned result
+void add(RealNumber& result, const RealNumber& a, const RealNumber& b) {
+	result = a + b;
+}
+
+void sub(RealNumber& result, const RealNumber& a, const RealNumber& b) {
+	result = a - b;
+}
+
+void mul(RealNumber& result, const RealNumber& a, const RealNumber& b) {
+	result = a * b;
+}
+
+void div(RealNumber& result, const RealNumber& a, const RealNumber& b) {
+	if (a.precision != b.precision) {
+		result = a / b;
+		return;
+	}
+	result.set_precision(a.precision);
+	a.divide(b, result, array_arithmetic::Workspace::local());
+}
@@ -0,0 +1,61 @@
+/**
+ * real_task_graph.cpp
+ * RealTaskGraph class implementation
+ *
+ * Copyright (c) 2012 Marshall Farrier
+ * license http://opensource.org/licenses/gpl-license.php GNU Public License
+ */
+
+#include <stdexcept>
+
+#include "real_task_graph.h"
+#include "array_arithmetic.h"
+
+RealTaskGraph::RealTaskGraph() : remaining_size(0) {}
+
+RealTaskGraph::Node RealTaskGraph::add(const std::function<void()>& operation,
+        const std::vector<Node>& dependencies) {
+    const Node NODE = vertices.size();
+    for (std::size_t i = 0; i < dependencies.size(); ++i) {
+        if (dependencies[i] >= NODE) { throw std::invalid_argument("Dependency must be an earlier node!"); }
+    }
+    Vertex vertex;
+    vertex.operation = operation;
+    vertex.dependency_count = dependencies.size();
+    vertices.push_back(vertex);
+    for (std::size_t i = 0; i < dependencies.size(); ++i) {
+        vertices[dependencies[i]].successors.push_back(NODE);
+    }
+    return NODE;
+}
+
+std::size_t RealTaskGraph::size() const { return vertices.size(); }
+
+void RealTaskGraph::run(const bool& concurrent) {
+    // every dependency comes before its node, so the order of addition works serially
+    if (!concurrent || array_arithmetic::get_thread_count() == 1) {
+        for (std::size_t i = 0; i < vertices.size(); ++i) { vertices[i].operation(); }
+        return;
+    }
+    // allocated on the first run only, so that running in a loop doesn't allocate here
+    if (remaining_size != vertices.size()) {
+        remaining.reset(new std::atomic<std::size_t>[vertices.size()]);
+        remaining_size = vertices.size();
+    }
+    for (std::size_t i = 0; i < vertices.size(); ++i) { remaining[i] = vertices[i].dependency_count; }
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        if (vertices[i].dependency_count == 0) { group.run([this, i]() { execute(i); }); }
+    }
+    group.wait();
+}
+
+// PRIVATE HELPER METHODS
+void RealTaskGraph::execute(const Node& node) {
+    vertices[node].operation();
+    const std::vector<Node>& successors = vertices[node].successors;
+    for (std::size_t i = 0; i < successors.size(); ++i) {
+        const Node SUCCESSOR = successors[i];
+        // the last dependency to finish queues the node
+        if (--remaining[SUCCESSOR] == 0) { group.run([this, SUCCESSOR]() { execute(SUCCESSOR); }); }
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ * Times the square root with division, ConvergentSeries::babylonian_sqrt(num),
+ * against the division-free ConvergentSeries::sqrt(), and gauss_legendre_pi()
+ * with each, over a range of precisions
+ * For meaningful timings build with optimization, e.g.:
+ * make CPPFLAGS="-std=c++11 -pthread -I include -O2" sqrt_benchmark
+ *
+ * Copyright (c) 2012 Marshall Farrier
+ * license http://opensource.org/licenses/gpl-license.php GNU Public License
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+
+#include "real_number.h"
+#include "convergent_series.h"
+
+using namespace std;
+
+namespace {
+	// average seconds per call of f, repeated for at least 0.2 s
+	template <class F>
+	double seconds_per_call(F f) {
+		typedef chrono::steady_clock clock;
+		std::size_t calls = 0;
+		clock::time_point start = clock::now();
+		double elapsed;
+		do {
+			f();
+			++calls;
+			elapsed = chrono::duration<double>(clock::now() - start).count();
+		} while (elapsed < 0.2);
+		return elapsed / calls;
+	}
+}
+
+int main()
+{
+	const std::size_t LIMBS[] = {13, 50, 200, 1000, 5000, 20000};
+	cout << setw(8) << "limbs" << setw(16) << "babylonian ms" << setw(16) << "sqrt ms"
+			<< setw(16) << "pi divide ms" << setw(16) << "pi no div ms" << endl;
+	for (std::size_t i = 0; i < sizeof(LIMBS) / sizeof(LIMBS[0]); ++i) {
+		const std::size_t P = LIMBS[i];
+		const RealNumber two("2.0", P);
+		double babylonian = seconds_per_call([&]() { ConvergentSeries::babylonian_sqrt(two); });
+		double division_free = seconds_per_call([&]() { ConvergentSeries::sqrt(two); });
+		// enough iterations for the precision, since both converge quadratically
+		std::size_t pi_iterations = 1;
+		while ((static_cast<std::size_t>(1) << pi_iterations) < P * 10) { ++pi_iterations; }
+		const RealNumber sqrt_two = ConvergentSeries::sqrt(two);
+		// the babylonian iterations per square root starting from a_next
+		double pi_divide = seconds_per_call([&]() {
+			ConvergentSeries::gauss_legendre_pi(pi_iterations, pi_iterations, sqrt_two);
+		});
+		double pi_division_free = seconds_per_call([&]() {
+			ConvergentSeries::gauss_legendre_pi(pi_iterations, P);
+		});
+		cout << fixed << setprecision(3) << setw(8) << P << setw(16) << babylonian * 1e3
+				<< setw(16) << division_free * 1e3 << setw(16) << pi_divide * 1e3
+				<< setw(16) << pi_division_free * 1e3 << endl;
+	}
+}
@@ -14,21 +14,30 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MAIN
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <stdexcept>
+#include <cstdlib>
+#include <string>
+#include <vector>
 
 #include "array_arithmetic.h"
 
+array_arithmetic::limb random_limb() {
+	return (static_cast<array_arithmetic::limb>(std::rand()) << 16) ^ std::rand();
+}
+
 struct ArraySize {
 	int small;
 	int large;
-	unsigned char* small_array;
-	unsigned char* large_array;
+	array_arithmetic::limb* small_array;
+	array_arithmetic::limb* large_array;
 	ArraySize() {
 		small = 4;
 		large = 8;
-		small_array = new unsigned char[small];
-		large_array = new unsigned char[large];
+		small_array = new array_arithmetic::limb[small];
+		large_array = new array_arithmetic::limb[large];
 	}
 	~ArraySize() {
 		delete[] small_array;
@@ -52,6 +61,69 @@ BOOST_FIXTURE_TEST_SUITE(conversion, ArraySize)
 		BOOST_CHECK_EQUAL(array_arithmetic::convert::to_int(small_array, small), ONE_BILLION);
 		BOOST_CHECK_EQUAL(array_arithmetic::convert::to_int(large_array, large), ONE_BILLION);
 	}
+
+	BOOST_AUTO_TEST_CASE(power_of_ten) {
+		// 10^19 = 0x8AC7230489E80000
+		const std::size_t LEN = array_arithmetic::convert::power_of_ten_len(19);
+		array_arithmetic::limb* power = new array_arithmetic::limb[LEN];
+		array_arithmetic::convert::power_of_ten(19, power, LEN);
+		BOOST_CHECK(array_arithmetic::helpers::is_zero(power, LEN - 2));
+		BOOST_CHECK_EQUAL(power[LEN - 2], 0x8AC72304u);
+		BOOST_CHECK_EQUAL(power[LEN - 1], 0x89E80000u);
+		array_arithmetic::convert::power_of_ten(0, power, LEN);
+		BOOST_CHECK_EQUAL(power[LEN - 1], 1u);
+		delete[] power;
+	}
+
+	BOOST_AUTO_TEST_CASE(to_decimal_digits) {
+		array_arithmetic::limb small_number[] = {0, 0x8AC72304u, 0x89E80000u};
+		char small_digits[25];
+		array_arithmetic::convert::to_decimal_digits(small_number, 3, small_digits, 25);
+		BOOST_CHECK_EQUAL(std::string(small_digits, 25), "0000010000000000000000000");
+		// 10^1000 - 1 and 10^1000 are long enough to be split recursively
+		const std::size_t EXPONENT = 1000;
+		const std::size_t LEN = array_arithmetic::convert::power_of_ten_len(EXPONENT);
+		array_arithmetic::limb* power = new array_arithmetic::limb[LEN];
+		char* digits = new char[EXPONENT + 1];
+		array_arithmetic::convert::power_of_ten(EXPONENT, power, LEN);
+		array_arithmetic::convert::to_decimal_digits(power, LEN, digits, EXPONENT + 1);
+		BOOST_CHECK_EQUAL(std::string(digits, EXPONENT + 1), std::string("1").append(EXPONENT, '0'));
+		const array_arithmetic::limb ONE = 1;
+		array_arithmetic::subtract(power, &ONE, power, LEN, 1);
+		array_arithmetic::convert::to_decimal_digits(power, LEN, digits, EXPONENT);
+		BOOST_CHECK_EQUAL(std::string(digits, EXPONENT), std::string(EXPONENT, '9'));
+		delete[] power;
+		delete[] digits;
+	}
+
+	BOOST_AUTO_TEST_CASE(from_decimal_digits) {
+		array_arithmetic::limb small_number[3];
+		array_arithmetic::convert::from_decimal_digits("0018446744073709551617", 22, small_number, 3);
+		// 2^64 + 1
+		BOOST_CHECK_EQUAL(small_number[0], 1u);
+		BOOST_CHECK_EQUAL(small_number[1], 0u);
+		BOOST_CHECK_EQUAL(small_number[2], 1u);
+		BOOST_CHECK_THROW(array_arithmetic::convert::from_decimal_digits("12.", 3, small_number, 3), 
+				std::invalid_argument);
+		// long enough to be split recursively
+		const std::size_t DIGITS = 2000;
+		const std::size_t LEN = array_arithmetic::convert::power_of_ten_len(DIGITS);
+		std::string str;
+		for (std::size_t i = 0; i < DIGITS; ++i) { str.push_back(static_cast<char>('0' + random_limb() % 10)); }
+		array_arithmetic::limb* number = new array_arithmetic::limb[LEN];
+		char* digits = new char[DIGITS];
+		array_arithmetic::convert::from_decimal_digits(str.data(), DIGITS, number, LEN);
+		array_arithmetic::convert::to_decimal_digits(number, LEN, digits, DIGITS);
+		BOOST_CHECK_EQUAL(std::string(digits, DIGITS), str);
+		array_arithmetic::convert::from_decimal_digits(std::string("1").append(DIGITS - 1, '0').data(), 
+				DIGITS, number, LEN);
+		array_arithmetic::limb* power = new array_arithmetic::limb[LEN];
+		array_arithmetic::convert::power_of_ten(DIGITS - 1, power, LEN);
+		for (std::size_t i = 0; i < LEN; ++i) { BOOST_CHECK_EQUAL(number[i], power[i]); }
+		delete[] number;
+		delete[] digits;
+		delete[] power;
+	}
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(conversion_helpers)
@@ -62,32 +134,39 @@ BOOST_AUTO_TEST_SUITE(conversion_helpers)
 		BOOST_CHECK_EQUAL(digits1[2], static_cast<unsigned char>(3));
 		delete[] digits1;
 		BOOST_CHECK_THROW(array_arithmetic::convert::helpers::to_digit_array("12."), std::invalid_argument); 
+		unsigned char digits2[2];
+		array_arithmetic::convert::helpers::to_digit_array("0.45", 2, digits2);
+		BOOST_CHECK_EQUAL(digits2[0], static_cast<unsigned char>(4));
+		BOOST_CHECK_EQUAL(digits2[1], static_cast<unsigned char>(5));
 	}
 
 	BOOST_AUTO_TEST_CASE(times_radix) {
+		// 0.33 * 2 ^ 32 = 1417339207.68
 		unsigned char digits[] = {3, 3};
-		BOOST_CHECK_EQUAL(array_arithmetic::convert::helpers::times_radix(digits, 2), 84);
-		BOOST_CHECK_EQUAL(digits[0], 4);
+		BOOST_CHECK_EQUAL(array_arithmetic::convert::helpers::times_radix(digits, 2), 
+				static_cast<array_arithmetic::limb>(1417339207));
+		BOOST_CHECK_EQUAL(digits[0], 6);
 		BOOST_CHECK_EQUAL(digits[1], 8);
 	}
 	BOOST_AUTO_TEST_CASE(times_ten) {
-		unsigned char digits[] = {100, 100};
-		BOOST_CHECK_EQUAL(array_arithmetic::convert::helpers::times_ten(digits, 2), 3);
-		BOOST_CHECK_EQUAL(digits[0], 235);
-		BOOST_CHECK_EQUAL(digits[1], 232);
+		// represents 0.5 + 0.5 / 2 ^ 32
+		array_arithmetic::limb digits[] = {2147483648u, 2147483648u};
+		BOOST_CHECK_EQUAL(array_arithmetic::convert::helpers::times_ten(digits, 2), 5);
+		BOOST_CHECK_EQUAL(digits[0], static_cast<array_arithmetic::limb>(5));
+		BOOST_CHECK_EQUAL(digits[1], static_cast<array_arithmetic::limb>(0));
 	}
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(helpers)
 	BOOST_AUTO_TEST_CASE(copy_into) {
-		unsigned char source_arr[] = {0, 1, 2};
-		unsigned char target_arr[5];
+		array_arithmetic::limb source_arr[] = {0, 1, 2};
+		array_arithmetic::limb target_arr[5];
 		array_arithmetic::helpers::copy_into(source_arr, target_arr, 3, 5);
 		BOOST_CHECK_EQUAL(target_arr[1], 1);
 		BOOST_CHECK_EQUAL(target_arr[3], 0);
 	}
 	BOOST_AUTO_TEST_CASE(shift_right) {
-		unsigned char arr[] = {1, 2, 3, 4, 5};
+		array_arithmetic::limb arr[] = {1, 2, 3, 4, 5};
 		array_arithmetic::helpers::shift_right(arr, 2, 5);
 		BOOST_CHECK_EQUAL(arr[0], 0);
 		BOOST_CHECK_EQUAL(arr[1], 0);
@@ -95,9 +174,9 @@ BOOST_AUTO_TEST_SUITE(helpers)
 		BOOST_CHECK_EQUAL(arr[4], 3);
 	}
 	BOOST_AUTO_TEST_CASE(less_or_equal) {
-		unsigned char arr1[] = {1, 1};
-		unsigned char arr2[] = {1, 2};
-		unsigned char arr3[] = {2, 1};
+		array_arithmetic::limb arr1[] = {1, 1};
+		array_arithmetic::limb arr2[] = {1, 2};
+		array_arithmetic::limb arr3[] = {2, 1};
 		// case of equality
 		BOOST_CHECK(array_arithmetic::helpers::less_or_equal(arr1, arr1, 2));
 		// inequality
@@ -107,15 +186,62 @@ BOOST_AUTO_TEST_SUITE(helpers)
 		BOOST_CHECK(!array_arithmetic::helpers::less_or_equal(arr2, arr1, 2));
 	}
 	BOOST_AUTO_TEST_CASE(is_zero) {
-		unsigned char arr1[] = {0, 0};
-		unsigned char arr2[] = {0, 0, 0, 0, 1};
-		unsigned char arr3[] = {1, 0};
+		array_arithmetic::limb arr1[] = {0, 0};
+		array_arithmetic::limb arr2[] = {0, 0, 0, 0, 1};
+		array_arithmetic::limb arr3[] = {1, 0};
 		BOOST_CHECK(array_arithmetic::helpers::is_zero(arr1, 2));
 		BOOST_CHECK(!array_arithmetic::helpers::is_zero(arr2, 5));
 		BOOST_CHECK(!array_arithmetic::helpers::is_zero(arr3, 2));
 	}
+	BOOST_AUTO_TEST_CASE(within_ulps) {
+		// 15 units of the last limb apart across a borrow
+		array_arithmetic::limb arr1[] = {1, 0, 0, 5};
+		array_arithmetic::limb arr2[] = {0, array_arithmetic::RADIX_MINUS_ONE, array_arithmetic::RADIX_MINUS_ONE,
+				array_arithmetic::RADIX_MINUS_ONE - 9};
+		BOOST_CHECK(array_arithmetic::helpers::within_ulps(arr1, 4, arr2, 4, 15));
+		BOOST_CHECK(array_arithmetic::helpers::within_ulps(arr2, 4, arr1, 4, 15));
+		BOOST_CHECK(!array_arithmetic::helpers::within_ulps(arr1, 4, arr2, 4, 14));
+		BOOST_CHECK(array_arithmetic::helpers::within_ulps(arr1, 4, arr1, 4, 0));
+		arr2[3] = array_arithmetic::RADIX_MINUS_ONE - 10;
+		BOOST_CHECK(!array_arithmetic::helpers::within_ulps(arr1, 4, arr2, 4, 15));
+		// RADIX and RADIX - 1 apart
+		arr2[3] = 5;
+		BOOST_CHECK(!array_arithmetic::helpers::within_ulps(arr1, 4, arr2, 4, 15));
+		arr2[3] = 6;
+		BOOST_CHECK(!array_arithmetic::helpers::within_ulps(arr2, 4, arr1, 4, 15));
+		// no borrow
+		arr2[0] = 1;
+		arr2[1] = arr2[2] = 0;
+		arr2[3] = 20;
+		BOOST_CHECK(array_arithmetic::helpers::within_ulps(arr1, 4, arr2, 4, 15));
+		arr2[3] = 21;
+		BOOST_CHECK(!array_arithmetic::helpers::within_ulps(arr1, 4, arr2, 4, 15));
+		// different lengths: the tolerance is in units of the last limb of arr3
+		array_arithmetic::limb arr3[] = {1, 15};
+		array_arithmetic::limb arr4[] = {1, 0, 0};
+		BOOST_CHECK(array_arithmetic::helpers::within_ulps(arr3, 2, arr4, 3, 15));
+		arr4[2] = 1;
+		BOOST_CHECK(array_arithmetic::helpers::within_ulps(arr3, 2, arr4, 3, 15));
+		arr4[1] = 30;
+		arr4[2] = 0;
+		BOOST_CHECK(array_arithmetic::helpers::within_ulps(arr3, 2, arr4, 3, 15));
+		BOOST_CHECK(!array_arithmetic::helpers::within_ulps(arr4, 3, arr3, 2, 14));
+		// the remaining limbs of the larger, longer array add to the difference
+		arr4[2] = 1;
+		BOOST_CHECK(!array_arithmetic::helpers::within_ulps(arr4, 3, arr3, 2, 15));
+		BOOST_CHECK(array_arithmetic::helpers::within_ulps(arr4, 3, arr3, 2, 16));
+		// equal common limbs: within 0 units only if the rest of the longer array is 0
+		array_arithmetic::limb arr5[] = {1, 2};
+		array_arithmetic::limb arr6[] = {1, 2, 5};
+		BOOST_CHECK(!array_arithmetic::helpers::within_ulps(arr5, 2, arr6, 3, 0));
+		BOOST_CHECK(!array_arithmetic::helpers::within_ulps(arr6, 3, arr5, 2, 0));
+		BOOST_CHECK(array_arithmetic::helpers::within_ulps(arr5, 2, arr6, 3, 1));
+		arr6[2] = 0;
+		BOOST_CHECK(array_arithmetic::helpers::within_ulps(arr5, 2, arr6, 3, 0));
+		BOOST_CHECK(array_arithmetic::helpers::within_ulps(arr5, 2, arr5, 2, 0));
+	}
 	BOOST_AUTO_TEST_CASE(set_to_zero) {
-		unsigned char arr[] = {1, 129, 255};
+		array_arithmetic::limb arr[] = {1, 129, 4294967295u};
 		array_arithmetic::helpers::set_to_zero(arr, 3);
 		BOOST_CHECK_EQUAL(arr[0], 0);
 		BOOST_CHECK_EQUAL(arr[1], 0);
@@ -125,11 +251,11 @@ BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(division_helpers)
 	BOOST_AUTO_TEST_CASE(align_dividend) {
-		unsigned char arr1[] = {129, 0};
-		unsigned char arr2[] = {0, 129};
+		array_arithmetic::limb arr1[] = {129, 0};
+		array_arithmetic::limb arr2[] = {0, 129};
 		int result = array_arithmetic::helpers::division::align_dividend(arr1, arr2, 2);
 		// verify proper return value
-		BOOST_CHECK_EQUAL(result, -9);
+		BOOST_CHECK_EQUAL(result, -33);
 		// verify that arr1 was properly shifted
 		BOOST_CHECK_EQUAL(arr1[0], 0);
 		BOOST_CHECK_EQUAL(arr1[1], 64);
@@ -138,10 +264,10 @@ BOOST_AUTO_TEST_SUITE(division_helpers)
 		BOOST_CHECK_EQUAL(arr2[1], 129);
 	}
 	BOOST_AUTO_TEST_CASE(align_divisor) {
-		unsigned char arr1[] = {129, 0};
-		unsigned char arr2[] = {0, 129};
+		array_arithmetic::limb arr1[] = {129, 0};
+		array_arithmetic::limb arr2[] = {0, 129};
 		// verify proper return value
-		BOOST_CHECK_EQUAL(array_arithmetic::helpers::division::align_divisor(arr2, arr1, 2), 8);
+		BOOST_CHECK_EQUAL(array_arithmetic::helpers::division::align_divisor(arr2, arr1, 2), 32);
 		// verify that arr1 was properly shifted
 		BOOST_CHECK_EQUAL(arr1[0], 0);
 		BOOST_CHECK_EQUAL(arr1[1], 129);
@@ -150,10 +276,10 @@ BOOST_AUTO_TEST_SUITE(division_helpers)
 		BOOST_CHECK_EQUAL(arr2[1], 129);
 	}
 	BOOST_AUTO_TEST_CASE(align) {
-		unsigned char arr1[] = {129, 0};
-		unsigned char arr2[] = {0, 129};
+		array_arithmetic::limb arr1[] = {129, 0};
+		array_arithmetic::limb arr2[] = {0, 129};
 		// verify proper return value
-		BOOST_CHECK_EQUAL(array_arithmetic::helpers::division::align(arr1, arr2, 2), -8);
+		BOOST_CHECK_EQUAL(array_arithmetic::helpers::division::align(arr1, arr2, 2), -32);
 		// arr1 properly shifted
 		BOOST_CHECK_EQUAL(arr1[0], 0);
 		BOOST_CHECK_EQUAL(arr1[1], 64);
@@ -162,12 +288,12 @@ BOOST_AUTO_TEST_SUITE(division_helpers)
 		BOOST_CHECK_EQUAL(arr2[1], 64);
 	}
 	BOOST_AUTO_TEST_CASE(readjust) {
-		unsigned char arr1[] = {129, 0};
-		unsigned char arr2[] = {0, 129};
-		unsigned char zero_arr[] = {0, 0};
-		unsigned char arr3[] = {129, 129};
+		array_arithmetic::limb arr1[] = {129, 0};
+		array_arithmetic::limb arr2[] = {0, 129};
+		array_arithmetic::limb zero_arr[] = {0, 0};
+		array_arithmetic::limb arr3[] = {129, 129};
 		// verify proper return value
-		BOOST_CHECK_EQUAL(array_arithmetic::helpers::division::readjust(arr2, arr1, 2), 8);
+		BOOST_CHECK_EQUAL(array_arithmetic::helpers::division::readjust(arr2, arr1, 2), 32);
 		// arr1 properly shifted
 		BOOST_CHECK_EQUAL(arr1[0], 0);
 		BOOST_CHECK_EQUAL(arr1[1], 129);
@@ -175,7 +301,7 @@ BOOST_AUTO_TEST_SUITE(division_helpers)
 		BOOST_CHECK_EQUAL(arr2[0], 0);
 		BOOST_CHECK_EQUAL(arr2[1], 129);
 		// check edge case when dividend is 0
-		BOOST_CHECK_EQUAL(array_arithmetic::helpers::division::readjust(zero_arr, arr3, 2), 16);
+		BOOST_CHECK_EQUAL(array_arithmetic::helpers::division::readjust(zero_arr, arr3, 2), 40);
 		BOOST_CHECK_EQUAL(arr3[0], 0);
 		BOOST_CHECK_EQUAL(arr3[1], 0);
 	}
@@ -183,42 +309,44 @@ BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(bits)
 	BOOST_AUTO_TEST_CASE(get_mask) {
-		BOOST_CHECK_EQUAL(array_arithmetic::bits::get_mask(0), 0);
-		BOOST_CHECK_EQUAL(array_arithmetic::bits::get_mask(2), 3);
-		BOOST_CHECK_EQUAL(array_arithmetic::bits::get_mask(8), 255);
-		BOOST_CHECK_EQUAL(array_arithmetic::bits::get_mask(7), 127);
+		BOOST_CHECK_EQUAL(array_arithmetic::bits::get_mask(0), 0u);
+		BOOST_CHECK_EQUAL(array_arithmetic::bits::get_mask(2), 3u);
+		BOOST_CHECK_EQUAL(array_arithmetic::bits::get_mask(8), 255u);
+		BOOST_CHECK_EQUAL(array_arithmetic::bits::get_mask(7), 127u);
+		BOOST_CHECK_EQUAL(array_arithmetic::bits::get_mask(32), array_arithmetic::RADIX_MINUS_ONE);
 	}
 	BOOST_AUTO_TEST_CASE(shift_right) {
-		unsigned char arr[] = {129, 129, 129};
+		array_arithmetic::limb arr[] = {129, 129, 129};
 		array_arithmetic::bits::shift_right(arr, 1, 3);
-		BOOST_CHECK_EQUAL(arr[0], 64);
-		BOOST_CHECK_EQUAL(arr[1], 192);
-		BOOST_CHECK_EQUAL(arr[2], 192);
+		// the low bit of each limb moves to the high bit of the next one
+		BOOST_CHECK_EQUAL(arr[0], 64u);
+		BOOST_CHECK_EQUAL(arr[1], 2147483712u);
+		BOOST_CHECK_EQUAL(arr[2], 2147483712u);
 		// reset array to original values
 		for (std::size_t i = 0; i < 3; ++i) { arr[i] = 129; }
-		array_arithmetic::bits::shift_right(arr, 15, 3);
-		BOOST_CHECK_EQUAL(arr[0], 0);
-		BOOST_CHECK_EQUAL(arr[1], 1);
-		BOOST_CHECK_EQUAL(arr[2], 3);
+		array_arithmetic::bits::shift_right(arr, 33, 3);
+		BOOST_CHECK_EQUAL(arr[0], 0u);
+		BOOST_CHECK_EQUAL(arr[1], 64u);
+		BOOST_CHECK_EQUAL(arr[2], 2147483712u);
 	}
 	BOOST_AUTO_TEST_CASE(set) {
-		unsigned char arr[] = {0, 0};
+		array_arithmetic::limb arr[] = {0, 0};
 		// test setting first bit at each index
 		array_arithmetic::bits::set(arr, 0);
-		BOOST_CHECK_EQUAL(arr[0], 128);
-		array_arithmetic::bits::set(arr, 8);
-		BOOST_CHECK_EQUAL(arr[1], 128);
+		BOOST_CHECK_EQUAL(arr[0], 2147483648u);
+		array_arithmetic::bits::set(arr, 32);
+		BOOST_CHECK_EQUAL(arr[1], 2147483648u);
 		// reset arr
 		for (std::size_t i = 0; i < 2; ++i) { arr[i] = 0; }
 		// test setting last bit at each index
-		array_arithmetic::bits::set(arr, 7);
-		BOOST_CHECK_EQUAL(arr[0], 1);
-		array_arithmetic::bits::set(arr, 15);
-		BOOST_CHECK_EQUAL(arr[1], 1);
+		array_arithmetic::bits::set(arr, 31);
+		BOOST_CHECK_EQUAL(arr[0], 1u);
+		array_arithmetic::bits::set(arr, 63);
+		BOOST_CHECK_EQUAL(arr[1], 1u);
 		// verify that there is no change to bits that are already set
-		arr[0] = 255;
+		arr[0] = array_arithmetic::RADIX_MINUS_ONE;
 		array_arithmetic::bits::set(arr, 3);
-		BOOST_CHECK_EQUAL(arr[0], 255);
+		BOOST_CHECK_EQUAL(arr[0], array_arithmetic::RADIX_MINUS_ONE);
 	}
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -233,17 +361,17 @@ struct MathTestCases {
 	unsigned int three_billion;
 	std::size_t small_arr_len;
 	std::size_t bigger_arr_len;	// to be used for a array
-	unsigned char* small_arr1;
-	unsigned char* small_arr2;
-	unsigned char* small_arr3;
-	unsigned char* smaller_arr;
-	unsigned char* small_result_arr;
-	unsigned char* bigger_arr1;
-	unsigned char* bigger_arr2;
-	unsigned char* bigger_arr3;
-	unsigned char* big_arr;
-	unsigned char* big_sum_arr;
-	unsigned char* big_product_arr;
+	array_arithmetic::limb* small_arr1;
+	array_arithmetic::limb* small_arr2;
+	array_arithmetic::limb* small_arr3;
+	array_arithmetic::limb* smaller_arr;
+	array_arithmetic::limb* small_result_arr;
+	array_arithmetic::limb* bigger_arr1;
+	array_arithmetic::limb* bigger_arr2;
+	array_arithmetic::limb* bigger_arr3;
+	array_arithmetic::limb* big_arr;
+	array_arithmetic::limb* big_sum_arr;
+	array_arithmetic::limb* big_product_arr;
 	MathTestCases() {
 		one = 1;
 		two = 2;
@@ -255,17 +383,17 @@ struct MathTestCases {
 		three_billion = 3000000000;
 		small_arr_len = 2;
 		bigger_arr_len = 4;
-		small_arr1 = new unsigned char[small_arr_len];
-		small_arr2 = new unsigned char[small_arr_len];
-		small_arr3 = new unsigned char[small_arr_len];
-		smaller_arr = new unsigned char[small_arr_len - 1];
-		small_result_arr = new unsigned char[small_arr_len + 1];
-		bigger_arr1 = new unsigned char[bigger_arr_len];
-		bigger_arr2 = new unsigned char[bigger_arr_len];
-		bigger_arr3 = new unsigned char[bigger_arr_len];
-		big_arr = new unsigned char[bigger_arr_len - 2];
-		big_sum_arr = new unsigned char[bigger_arr_len + 1];
-		big_product_arr = new unsigned char[2 * bigger_arr_len - 1];
+		small_arr1 = new array_arithmetic::limb[small_arr_len];
+		small_arr2 = new array_arithmetic::limb[small_arr_len];
+		small_arr3 = new array_arithmetic::limb[small_arr_len];
+		smaller_arr = new array_arithmetic::limb[small_arr_len - 1];
+		small_result_arr = new array_arithmetic::limb[small_arr_len + 1];
+		bigger_arr1 = new array_arithmetic::limb[bigger_arr_len];
+		bigger_arr2 = new array_arithmetic::limb[bigger_arr_len];
+		bigger_arr3 = new array_arithmetic::limb[bigger_arr_len];
+		big_arr = new array_arithmetic::limb[bigger_arr_len - 2];
+		big_sum_arr = new array_arithmetic::limb[bigger_arr_len + 1];
+		big_product_arr = new array_arithmetic::limb[2 * bigger_arr_len - 1];
 	}
 	~MathTestCases() {
 		delete[] small_arr1;
@@ -298,6 +426,12 @@ BOOST_FIXTURE_TEST_SUITE(addition, MathTestCases)
 		array_arithmetic::add(bigger_arr1, bigger_arr2, bigger_arr3, bigger_arr_len);
 		BOOST_CHECK_EQUAL(array_arithmetic::convert::to_int(bigger_arr3, bigger_arr_len),
 				three_billion);
+		// carry across limbs
+		array_arithmetic::convert::from_int(array_arithmetic::RADIX_MINUS_ONE, small_arr1, small_arr_len);
+		array_arithmetic::convert::from_int(one, small_arr2, small_arr_len);
+		array_arithmetic::add(small_arr1, small_arr2, small_arr3, small_arr_len);
+		BOOST_CHECK_EQUAL(small_arr3[0], 1u);
+		BOOST_CHECK_EQUAL(small_arr3[1], 0u);
 	}
 	// adding arrays of different sizes
 	BOOST_AUTO_TEST_CASE(different_lengths) {
@@ -329,6 +463,17 @@ BOOST_FIXTURE_TEST_SUITE(subtraction, MathTestCases)
 		array_arithmetic::subtract(bigger_arr1, bigger_arr2, bigger_arr3, bigger_arr_len);
 		BOOST_CHECK_EQUAL(array_arithmetic::convert::to_int(bigger_arr3, bigger_arr_len),
 			one_billion);
+		// borrow across limbs
+		bigger_arr1[0] = 1;
+		bigger_arr1[1] = 0;
+		bigger_arr1[2] = 0;
+		bigger_arr1[3] = 0;
+		array_arithmetic::convert::from_int(one, bigger_arr2, bigger_arr_len);
+		array_arithmetic::subtract(bigger_arr1, bigger_arr2, bigger_arr3, bigger_arr_len);
+		BOOST_CHECK_EQUAL(bigger_arr3[0], 0u);
+		BOOST_CHECK_EQUAL(bigger_arr3[1], array_arithmetic::RADIX_MINUS_ONE);
+		BOOST_CHECK_EQUAL(bigger_arr3[2], array_arithmetic::RADIX_MINUS_ONE);
+		BOOST_CHECK_EQUAL(bigger_arr3[3], array_arithmetic::RADIX_MINUS_ONE);
 	}
 	// different array lengths
 	BOOST_AUTO_TEST_CASE(different_lengths) {
@@ -337,6 +482,38 @@ BOOST_FIXTURE_TEST_SUITE(subtraction, MathTestCases)
 		array_arithmetic::subtract(bigger_arr1, big_arr, bigger_arr2, bigger_arr_len, bigger_arr_len - 2);
 		BOOST_CHECK_EQUAL(array_arithmetic::convert::to_int(bigger_arr2, bigger_arr_len), one_billion);
 	}
+	// RADIX^(LEN - 1) - 1 borrows through every limb
+	BOOST_AUTO_TEST_CASE(long_borrow) {
+		const std::size_t LEN = 300;
+		const array_arithmetic::limb ONE = 1;
+		array_arithmetic::limb a[LEN], b[LEN], result[LEN];
+		array_arithmetic::helpers::set_to_zero(a, LEN);
+		array_arithmetic::helpers::set_to_zero(b, LEN);
+		a[0] = 1;
+		b[LEN - 1] = 1;
+		array_arithmetic::Workspace& ws = array_arithmetic::Workspace::local();
+		ws.reset_peak();
+		array_arithmetic::subtract(a, b, result, LEN);
+		BOOST_CHECK_EQUAL(result[0], 0u);
+		BOOST_CHECK(std::count(result + 1, result + LEN, array_arithmetic::RADIX_MINUS_ONE) == LEN - 1);
+		// in place, both overloads
+		array_arithmetic::subtract(a, b, a, LEN);
+		BOOST_CHECK(std::equal(result, result + LEN, a));
+		a[0] = 1;
+		array_arithmetic::helpers::set_to_zero(a + 1, LEN - 1);
+		array_arithmetic::subtract(a, &ONE, a, LEN, 1);
+		BOOST_CHECK(std::equal(result, result + LEN, a));
+		// a borrow chain that stops partway
+		a[0] = 1;
+		array_arithmetic::helpers::set_to_zero(a + 1, LEN - 1);
+		a[LEN / 2] = 5;
+		array_arithmetic::subtract(a, &ONE, a, LEN, 1);
+		BOOST_CHECK_EQUAL(a[0], 1u);
+		BOOST_CHECK_EQUAL(a[LEN / 2], 4u);
+		BOOST_CHECK(std::count(a + LEN / 2 + 1, a + LEN, array_arithmetic::RADIX_MINUS_ONE) == LEN - LEN / 2 - 1);
+		// no scratch memory
+		BOOST_CHECK_EQUAL(ws.get_peak(), 0u);
+	}
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_FIXTURE_TEST_SUITE(multiplication, MathTestCases)
@@ -347,50 +524,760 @@ BOOST_FIXTURE_TEST_SUITE(multiplication, MathTestCases)
 		BOOST_CHECK_EQUAL(array_arithmetic::convert::to_int(big_product_arr, bigger_arr_len * 2 - 1), 
 				two_billion);
 	}
+	BOOST_AUTO_TEST_CASE(karatsuba_multiply) {
+		array_arithmetic::convert::from_int(5000000, bigger_arr1, bigger_arr_len);
+		array_arithmetic::convert::from_int(400, big_arr, bigger_arr_len - 2);
+		array_arithmetic::karatsuba_multiply(bigger_arr1, big_arr, big_product_arr, bigger_arr_len, 
+				bigger_arr_len - 2);
+		BOOST_CHECK_EQUAL(array_arithmetic::convert::to_int(big_product_arr, bigger_arr_len * 2 - 1), 
+				two_billion);
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+/**
+ * compares karatsuba_multiply against school_multiply for the given lengths
+ * using arrays filled with the given value or with pseudo-random digits if fill is 0
+ */
+bool karatsuba_matches_school(const std::size_t& a_len, const std::size_t& b_len, 
+		const array_arithmetic::limb& fill) {
+	array_arithmetic::limb* a = new array_arithmetic::limb[a_len];
+	array_arithmetic::limb* b = new array_arithmetic::limb[b_len];
+	array_arithmetic::limb* expected = new array_arithmetic::limb[a_len + b_len + 1];
+	array_arithmetic::limb* actual = new array_arithmetic::limb[a_len + b_len + 1];
+	std::size_t i;
+	for (i = 0; i < a_len; ++i) { a[i] = fill == 0 ? random_limb() : fill; }
+	for (i = 0; i < b_len; ++i) { b[i] = fill == 0 ? random_limb() : fill; }
+	array_arithmetic::school_multiply(a, b, expected, a_len, b_len);
+	array_arithmetic::karatsuba_multiply(a, b, actual, a_len, b_len);
+	bool result = true;
+	for (i = 0; i < a_len + b_len + 1; ++i) {
+		if (expected[i] != actual[i]) { result = false; }
+	}
+	delete[] a;
+	delete[] b;
+	delete[] expected;
+	delete[] actual;
+	return result;
+}
+
+/**
+ * lowers the karatsuba threshold so that small arrays exercise the recursion
+ */
+struct KaratsubaThreshold {
+	std::size_t original_threshold;
+	KaratsubaThreshold() {
+		original_threshold = array_arithmetic::karatsuba_threshold;
+		std::srand(1);
+	}
+	~KaratsubaThreshold() {
+		array_arithmetic::karatsuba_threshold = original_threshold;
+	}
+};
+
+BOOST_FIXTURE_TEST_SUITE(karatsuba, KaratsubaThreshold)
+	BOOST_AUTO_TEST_CASE(balanced_lengths) {
+		array_arithmetic::karatsuba_threshold = 2;
+		for (std::size_t len = 1; len < 40; ++len) {
+			BOOST_CHECK(karatsuba_matches_school(len, len, 0));
+		}
+	}
+	BOOST_AUTO_TEST_CASE(unbalanced_lengths) {
+		array_arithmetic::karatsuba_threshold = 2;
+		for (std::size_t a_len = 1; a_len < 40; ++a_len) {
+			for (std::size_t b_len = 1; b_len <= a_len; b_len += 3) {
+				BOOST_CHECK(karatsuba_matches_school(a_len, b_len, 0));
+			}
+		}
+	}
+	BOOST_AUTO_TEST_CASE(maximum_digits) {
+		// all digits RADIX_MINUS_ONE maximizes the carries
+		array_arithmetic::karatsuba_threshold = 2;
+		BOOST_CHECK(karatsuba_matches_school(37, 37, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(karatsuba_matches_school(64, 33, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(karatsuba_matches_school(100, 7, array_arithmetic::RADIX_MINUS_ONE));
+	}
+	BOOST_AUTO_TEST_CASE(default_threshold) {
+		BOOST_CHECK(karatsuba_matches_school(54, 54, 0));
+		BOOST_CHECK(karatsuba_matches_school(300, 300, 0));
+		BOOST_CHECK(karatsuba_matches_school(500, 123, array_arithmetic::RADIX_MINUS_ONE));
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+typedef void (*multiply_function)(const array_arithmetic::limb*, const array_arithmetic::limb*,
+		array_arithmetic::limb*, const std::size_t&, const std::size_t&, array_arithmetic::Workspace&);
+
+/**
+ * compares the given multiplication function against school_multiply, like
+ * karatsuba_matches_school()
+ */
+bool product_matches_school(multiply_function product, const std::size_t& a_len, const std::size_t& b_len,
+		const array_arithmetic::limb& fill) {
+	array_arithmetic::limb* a = new array_arithmetic::limb[a_len];
+	array_arithmetic::limb* b = new array_arithmetic::limb[b_len];
+	array_arithmetic::limb* expected = new array_arithmetic::limb[a_len + b_len + 1];
+	array_arithmetic::limb* actual = new array_arithmetic::limb[a_len + b_len + 1];
+	std::size_t i;
+	for (i = 0; i < a_len; ++i) { a[i] = fill == 0 ? random_limb() : fill; }
+	for (i = 0; i < b_len; ++i) { b[i] = fill == 0 ? random_limb() : fill; }
+	array_arithmetic::school_multiply(a, b, expected, a_len, b_len);
+	product(a, b, actual, a_len, b_len, array_arithmetic::Workspace::local());
+	bool result = true;
+	for (i = 0; i < a_len + b_len + 1; ++i) {
+		if (expected[i] != actual[i]) { result = false; }
+	}
+	delete[] a;
+	delete[] b;
+	delete[] expected;
+	delete[] actual;
+	return result;
+}
+
+/**
+ * lowers all multiplication thresholds so that small arrays exercise each tier
+ */
+struct MultiplyThresholds {
+	std::size_t original_karatsuba;
+	std::size_t original_toom3;
+	std::size_t original_toom4;
+	MultiplyThresholds() {
+		original_karatsuba = array_arithmetic::karatsuba_threshold;
+		original_toom3 = array_arithmetic::toom3_threshold;
+		original_toom4 = array_arithmetic::toom4_threshold;
+		array_arithmetic::karatsuba_threshold = 4;
+		array_arithmetic::toom3_threshold = 8;
+		array_arithmetic::toom4_threshold = 16;
+		std::srand(1);
+	}
+	~MultiplyThresholds() {
+		array_arithmetic::karatsuba_threshold = original_karatsuba;
+		array_arithmetic::toom3_threshold = original_toom3;
+		array_arithmetic::toom4_threshold = original_toom4;
+	}
+};
+
+BOOST_FIXTURE_TEST_SUITE(toom_cook, MultiplyThresholds)
+	BOOST_AUTO_TEST_CASE(toom3_multiply) {
+		for (std::size_t a_len = 1; a_len < 50; ++a_len) {
+			for (std::size_t b_len = 1; b_len <= a_len; b_len += 2) {
+				BOOST_CHECK(product_matches_school(array_arithmetic::toom3_multiply, a_len, b_len, 0));
+			}
+		}
+	}
+	BOOST_AUTO_TEST_CASE(toom4_multiply) {
+		for (std::size_t a_len = 1; a_len < 50; ++a_len) {
+			for (std::size_t b_len = 1; b_len <= a_len; b_len += 2) {
+				BOOST_CHECK(product_matches_school(array_arithmetic::toom4_multiply, a_len, b_len, 0));
+			}
+		}
+	}
+	BOOST_AUTO_TEST_CASE(maximum_digits) {
+		BOOST_CHECK(product_matches_school(array_arithmetic::toom3_multiply, 61, 61, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(product_matches_school(array_arithmetic::toom3_multiply, 61, 35, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(product_matches_school(array_arithmetic::toom4_multiply, 83, 83, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(product_matches_school(array_arithmetic::toom4_multiply, 83, 42, array_arithmetic::RADIX_MINUS_ONE));
+	}
+	BOOST_AUTO_TEST_CASE(dispatcher) {
+		BOOST_CHECK(product_matches_school(array_arithmetic::multiply, 3, 2, 0));
+		BOOST_CHECK(product_matches_school(array_arithmetic::multiply, 12, 12, 0));
+		BOOST_CHECK(product_matches_school(array_arithmetic::multiply, 40, 25, 0));
+		BOOST_CHECK(product_matches_school(array_arithmetic::multiply, 300, 300, 0));
+		BOOST_CHECK(product_matches_school(array_arithmetic::multiply, 300, 7, 0));
+		BOOST_CHECK(product_matches_school(array_arithmetic::multiply, 200, 90, array_arithmetic::RADIX_MINUS_ONE));
+	}
+	BOOST_AUTO_TEST_CASE(default_thresholds) {
+		array_arithmetic::karatsuba_threshold = original_karatsuba;
+		array_arithmetic::toom3_threshold = original_toom3;
+		array_arithmetic::toom4_threshold = original_toom4;
+		BOOST_CHECK(product_matches_school(array_arithmetic::multiply, 1000, 1000, 0));
+		BOOST_CHECK(product_matches_school(array_arithmetic::multiply, 1500, 700, array_arithmetic::RADIX_MINUS_ONE));
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(ntt, MultiplyThresholds)
+	BOOST_AUTO_TEST_CASE(ntt_multiply) {
+		for (std::size_t a_len = 1; a_len < 40; ++a_len) {
+			for (std::size_t b_len = 1; b_len <= a_len; b_len += 3) {
+				BOOST_CHECK(product_matches_school(array_arithmetic::ntt_multiply, a_len, b_len, 0));
+			}
+		}
+	}
+	BOOST_AUTO_TEST_CASE(maximum_digits) {
+		// the largest coefficients of the convolution
+		BOOST_CHECK(product_matches_school(array_arithmetic::ntt_multiply, 2000, 2000, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(product_matches_school(array_arithmetic::ntt_multiply, 3001, 17, array_arithmetic::RADIX_MINUS_ONE));
+	}
+	BOOST_AUTO_TEST_CASE(dispatcher) {
+		std::size_t original_ntt = array_arithmetic::ntt_threshold;
+		array_arithmetic::ntt_threshold = 32;
+		BOOST_CHECK(product_matches_school(array_arithmetic::multiply, 100, 100, 0));
+		BOOST_CHECK(product_matches_school(array_arithmetic::multiply, 500, 300, 0));
+		BOOST_CHECK(product_matches_school(array_arithmetic::multiply, 500, 30, 0));
+		array_arithmetic::ntt_threshold = original_ntt;
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+/**
+ * checks that short_multiply() gives the leading result_len limbs of the
+ * school product or 1 less in the last limb
+ */
+bool short_product_matches_school(const std::size_t& len, const std::size_t& result_len,
+		const array_arithmetic::limb& fill) {
+	array_arithmetic::limb* a = new array_arithmetic::limb[len];
+	array_arithmetic::limb* b = new array_arithmetic::limb[len];
+	array_arithmetic::limb* expected = new array_arithmetic::limb[2 * len + 1];
+	array_arithmetic::limb* actual = new array_arithmetic::limb[result_len];
+	std::size_t i;
+	for (i = 0; i < len; ++i) {
+		a[i] = fill == 0 ? random_limb() : fill;
+		b[i] = fill == 0 ? random_limb() : fill;
+	}
+	array_arithmetic::school_multiply(a, b, expected, len, len);
+	array_arithmetic::short_multiply(a, b, actual, len, result_len);
+	bool result = std::equal(actual, actual + result_len, expected);
+	if (!result) {
+		// add 1 to the last limb
+		i = result_len;
+		while (i > 0 && ++actual[--i] == 0) { }
+		result = std::equal(actual, actual + result_len, expected);
+	}
+	delete[] a;
+	delete[] b;
+	delete[] expected;
+	delete[] actual;
+	return result;
+}
+
+BOOST_FIXTURE_TEST_SUITE(short_product, MultiplyThresholds)
+	BOOST_AUTO_TEST_CASE(school_range) {
+		array_arithmetic::karatsuba_threshold = 32;
+		for (std::size_t len = 1; len < 20; ++len) {
+			for (std::size_t result_len = 1; result_len <= 2 * len + 1; ++result_len) {
+				BOOST_CHECK(short_product_matches_school(len, result_len, 0));
+			}
+		}
+	}
+	BOOST_AUTO_TEST_CASE(mulders) {
+		// the triangles are used below toom4_threshold
+		array_arithmetic::toom4_threshold = 64;
+		for (std::size_t len = 4; len < 60; len += 5) {
+			for (std::size_t result_len = 1; result_len <= 2 * len + 1; result_len += 3) {
+				BOOST_CHECK(short_product_matches_school(len, result_len, 0));
+			}
+		}
+	}
+	BOOST_AUTO_TEST_CASE(maximum_digits) {
+		BOOST_CHECK(short_product_matches_school(14, 16, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(short_product_matches_school(57, 59, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(short_product_matches_school(57, 3, array_arithmetic::RADIX_MINUS_ONE));
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+typedef void (*square_function)(const array_arithmetic::limb*, array_arithmetic::limb*,
+		const std::size_t&, array_arithmetic::Workspace&);
+
+/**
+ * compares the given squaring function against school_multiply of a with itself
+ */
+bool square_matches_school(square_function square, const std::size_t& len,
+		const array_arithmetic::limb& fill) {
+	array_arithmetic::limb* a = new array_arithmetic::limb[len];
+	array_arithmetic::limb* expected = new array_arithmetic::limb[2 * len + 1];
+	array_arithmetic::limb* actual = new array_arithmetic::limb[2 * len + 1];
+	std::size_t i;
+	for (i = 0; i < len; ++i) { a[i] = fill == 0 ? random_limb() : fill; }
+	array_arithmetic::school_multiply(a, a, expected, len, len);
+	square(a, actual, len, array_arithmetic::Workspace::local());
+	bool result = true;
+	for (i = 0; i < 2 * len + 1; ++i) {
+		if (expected[i] != actual[i]) { result = false; }
+	}
+	delete[] a;
+	delete[] expected;
+	delete[] actual;
+	return result;
+}
+
+/**
+ * school_square() in the signature of the other squaring functions
+ */
+void school_square(const array_arithmetic::limb* a, array_arithmetic::limb* result,
+		const std::size_t& len, array_arithmetic::Workspace&) {
+	array_arithmetic::school_square(a, result, len);
+}
+
+BOOST_FIXTURE_TEST_SUITE(squaring, MultiplyThresholds)
+	BOOST_AUTO_TEST_CASE(school_square) {
+		for (std::size_t len = 1; len < 20; ++len) {
+			BOOST_CHECK(square_matches_school(::school_square, len, 0));
+			BOOST_CHECK(square_matches_school(::school_square, len, array_arithmetic::RADIX_MINUS_ONE));
+		}
+	}
+	BOOST_AUTO_TEST_CASE(each_tier) {
+		for (std::size_t len = 1; len < 50; ++len) {
+			BOOST_CHECK(square_matches_school(array_arithmetic::karatsuba_square, len, 0));
+			BOOST_CHECK(square_matches_school(array_arithmetic::toom3_square, len, 0));
+			BOOST_CHECK(square_matches_school(array_arithmetic::toom4_square, len, 0));
+			BOOST_CHECK(square_matches_school(array_arithmetic::ntt_square, len, 0));
+		}
+	}
+	BOOST_AUTO_TEST_CASE(maximum_digits) {
+		BOOST_CHECK(square_matches_school(array_arithmetic::karatsuba_square, 45, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(square_matches_school(array_arithmetic::toom3_square, 61, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(square_matches_school(array_arithmetic::toom4_square, 83, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(square_matches_school(array_arithmetic::ntt_square, 2000, array_arithmetic::RADIX_MINUS_ONE));
+	}
+	BOOST_AUTO_TEST_CASE(dispatcher) {
+		std::size_t original_ntt = array_arithmetic::ntt_threshold;
+		array_arithmetic::ntt_threshold = 32;
+		BOOST_CHECK(square_matches_school(array_arithmetic::square, 5, 0));
+		BOOST_CHECK(square_matches_school(array_arithmetic::square, 12, 0));
+		BOOST_CHECK(square_matches_school(array_arithmetic::square, 20, 0));
+		BOOST_CHECK(square_matches_school(array_arithmetic::square, 100, 0));
+		array_arithmetic::ntt_threshold = original_ntt;
+	}
+	BOOST_AUTO_TEST_CASE(multiply_same_array) {
+		// multiply() routes a product of an array with itself to square()
+		const std::size_t LEN = 40;
+		array_arithmetic::limb a[LEN], expected[2 * LEN + 1], actual[2 * LEN + 1];
+		for (std::size_t i = 0; i < LEN; ++i) { a[i] = random_limb(); }
+		array_arithmetic::school_multiply(a, a, expected, LEN, LEN);
+		array_arithmetic::multiply(a, a, actual, LEN, LEN);
+		BOOST_CHECK(std::equal(expected, expected + 2 * LEN + 1, actual));
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+struct SimdLevels {
+	array_arithmetic::SimdLevel original_level;
+	SimdLevels() {
+		original_level = array_arithmetic::simd_level;
+		std::srand(1);
+	}
+	~SimdLevels() {
+		array_arithmetic::simd_level = original_level;
+	}
+};
+
+/**
+ * fills a and b with random limbs, or with the given fills if these are nonzero,
+ * and checks that each supported vector level gives the scalar sum and difference,
+ * also when the result is written over a
+ */
+bool vector_matches_scalar(const std::size_t& len, const array_arithmetic::limb& a_fill,
+		const array_arithmetic::limb& b_fill) {
+	std::vector<array_arithmetic::limb> a(len), b(len), sum(len), diff(len), actual(len);
+	for (std::size_t i = 0; i < len; ++i) {
+		a[i] = a_fill == 0 ? random_limb() : a_fill;
+		b[i] = b_fill == 0 ? random_limb() : b_fill;
+	}
+	// subtraction requires b <= a
+	if (array_arithmetic::helpers::compare(&a[0], &b[0], len) < 0) { a.swap(b); }
+	array_arithmetic::simd_level = array_arithmetic::SIMD_SCALAR;
+	array_arithmetic::add(&a[0], &b[0], &sum[0], len);
+	array_arithmetic::subtract(&a[0], &b[0], &diff[0], len);
+	bool result = true;
+	for (int level = array_arithmetic::SIMD_SSE42; level <= array_arithmetic::supported_simd_level(); ++level) {
+		array_arithmetic::simd_level = static_cast<array_arithmetic::SimdLevel>(level);
+		array_arithmetic::add(&a[0], &b[0], &actual[0], len);
+		if (actual != sum) { result = false; }
+		array_arithmetic::subtract(&a[0], &b[0], &actual[0], len);
+		if (actual != diff) { result = false; }
+		actual = a;
+		array_arithmetic::add(&actual[0], &b[0], &actual[0], len);
+		if (actual != sum) { result = false; }
+		actual = a;
+		array_arithmetic::subtract(&actual[0], &b[0], &actual[0], len);
+		if (actual != diff) { result = false; }
+	}
+	return result;
+}
+
+BOOST_FIXTURE_TEST_SUITE(simd, SimdLevels)
+	BOOST_AUTO_TEST_CASE(random_limbs) {
+		for (std::size_t len = 1; len < 40; ++len) {
+			BOOST_CHECK(vector_matches_scalar(len, 0, 0));
+		}
+	}
+	BOOST_AUTO_TEST_CASE(long_carries) {
+		for (std::size_t len = 1; len < 40; ++len) {
+			// carries and borrows across every limb
+			BOOST_CHECK(vector_matches_scalar(len, array_arithmetic::RADIX_MINUS_ONE, 1));
+			BOOST_CHECK(vector_matches_scalar(len, array_arithmetic::RADIX_MINUS_ONE,
+					array_arithmetic::RADIX_MINUS_ONE));
+		}
+		const std::size_t LEN = 37;
+		std::vector<array_arithmetic::limb> a(LEN, 0), b(LEN, 0), result(LEN);
+		a[0] = 1;
+		b[LEN - 1] = 1;
+		for (int level = array_arithmetic::SIMD_SCALAR; level <= array_arithmetic::supported_simd_level(); ++level) {
+			array_arithmetic::simd_level = static_cast<array_arithmetic::SimdLevel>(level);
+			// 1 borrowed through 35 zeros
+			array_arithmetic::subtract(&a[0], &b[0], &result[0], LEN);
+			BOOST_CHECK_EQUAL(result[0], 0u);
+			BOOST_CHECK(std::count(result.begin() + 1, result.end(), array_arithmetic::RADIX_MINUS_ONE) == LEN - 1);
+			// and carried back
+			array_arithmetic::add(&result[0], &b[0], &result[0], LEN);
+			BOOST_CHECK(result == a);
+		}
+	}
+	BOOST_AUTO_TEST_CASE(different_lengths) {
+		const std::size_t A_LEN = 30, B_LEN = 19;
+		array_arithmetic::limb a[A_LEN], b[B_LEN], expected[A_LEN + 1], actual[A_LEN + 1];
+		for (std::size_t i = 0; i < A_LEN; ++i) { a[i] = i < 12 ? 0 : array_arithmetic::RADIX_MINUS_ONE; }
+		a[0] = 1;
+		for (std::size_t i = 0; i < B_LEN; ++i) { b[i] = random_limb(); }
+		array_arithmetic::simd_level = array_arithmetic::SIMD_SCALAR;
+		array_arithmetic::add(a, b, expected, A_LEN, B_LEN);
+		for (int level = array_arithmetic::SIMD_SSE42; level <= array_arithmetic::supported_simd_level(); ++level) {
+			array_arithmetic::simd_level = static_cast<array_arithmetic::SimdLevel>(level);
+			array_arithmetic::add(a, b, actual, A_LEN, B_LEN);
+			BOOST_CHECK(std::equal(expected, expected + A_LEN + 1, actual));
+		}
+		a[A_LEN - 1] = 0;
+		array_arithmetic::simd_level = array_arithmetic::SIMD_SCALAR;
+		array_arithmetic::subtract(a, b, expected, A_LEN, B_LEN);
+		for (int level = array_arithmetic::SIMD_SSE42; level <= array_arithmetic::supported_simd_level(); ++level) {
+			array_arithmetic::simd_level = static_cast<array_arithmetic::SimdLevel>(level);
+			array_arithmetic::subtract(a, b, actual, A_LEN, B_LEN);
+			BOOST_CHECK(std::equal(expected, expected + A_LEN, actual));
+		}
+	}
+	BOOST_AUTO_TEST_CASE(comparisons) {
+		const std::size_t LEN = 21;
+		array_arithmetic::limb a[LEN], b[LEN];
+		for (int level = array_arithmetic::SIMD_SCALAR; level <= array_arithmetic::supported_simd_level(); ++level) {
+			array_arithmetic::simd_level = static_cast<array_arithmetic::SimdLevel>(level);
+			for (std::size_t i = 0; i < LEN; ++i) {
+				for (std::size_t j = 0; j < LEN; ++j) { a[j] = b[j] = 7; }
+				BOOST_CHECK_EQUAL(array_arithmetic::helpers::compare(a, b, LEN), 0);
+				// a difference at index i outweighs the smaller limbs after it
+				b[i] = 8;
+				if (i + 1 < LEN) { a[i + 1] = array_arithmetic::RADIX_MINUS_ONE; }
+				BOOST_CHECK_EQUAL(array_arithmetic::helpers::compare(a, b, LEN), -1);
+				BOOST_CHECK_EQUAL(array_arithmetic::helpers::compare(b, a, LEN), 1);
+				BOOST_CHECK(array_arithmetic::helpers::less_or_equal(a, b, LEN));
+				BOOST_CHECK(!array_arithmetic::helpers::less_or_equal(b, a, LEN));
+				// the only nonzero limb is at index i
+				array_arithmetic::helpers::set_to_zero(a, LEN);
+				BOOST_CHECK(array_arithmetic::helpers::is_zero(a, LEN));
+				a[i] = 1;
+				BOOST_CHECK(!array_arithmetic::helpers::is_zero(a, LEN));
+			}
+		}
+	}
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(division)
 	BOOST_AUTO_TEST_CASE(divide_by_zero) {
-		unsigned char divisor[] = {0, 0, 0};
-		unsigned char dividend[] = {1, 1, 1};
-		unsigned char result[] = {129, 129, 129};
+		array_arithmetic::limb divisor[] = {0, 0, 0};
+		array_arithmetic::limb dividend[] = {1, 1, 1};
+		array_arithmetic::limb result[] = {129, 129, 129};
 		BOOST_CHECK_THROW(array_arithmetic::divide(dividend, divisor, result, 3, 1), std::invalid_argument);
 	}
 	BOOST_AUTO_TEST_CASE(dividend_is_zero) {
-		unsigned char dividend[] = {0, 0};
-		unsigned char divisor[] = {0, 1};
-		unsigned char result[] = {129, 13};
+		array_arithmetic::limb dividend[] = {0, 0};
+		array_arithmetic::limb divisor[] = {0, 1};
+		array_arithmetic::limb result[] = {129, 13};
 		array_arithmetic::divide(dividend, divisor, result, 2, 1);
 		BOOST_CHECK_EQUAL(result[0], 0);
 		BOOST_CHECK_EQUAL(result[1], 0);
 	}
 	BOOST_AUTO_TEST_CASE(result_too_big) {
-		unsigned char dividend[] = {128, 0};
-		unsigned char divisor[] = {0, 128};	// represents 0.5
-		unsigned char result[] = {255, 255};
+		array_arithmetic::limb dividend[] = {2147483648u, 0};
+		array_arithmetic::limb divisor[] = {0, 2147483648u};	// represents 0.5
+		array_arithmetic::limb result[] = {255, 255};
 		BOOST_CHECK_THROW(array_arithmetic::divide(dividend, divisor, result, 2, 1), std::overflow_error);
 	}
 	BOOST_AUTO_TEST_CASE(exact_result) {
 		// this also tests that we exit the loop properly when the long division subtraction
 		// gives a 0 result
-		unsigned char dividend[] = {1, 0, 0};
-		unsigned char divisor[] = {2, 0, 0};	// result should represent 0.5
-		unsigned char result[] = {3, 4, 5};
+		array_arithmetic::limb dividend[] = {1, 0, 0};
+		array_arithmetic::limb divisor[] = {2, 0, 0};	// result should represent 0.5
+		array_arithmetic::limb result[] = {3, 4, 5};
 		array_arithmetic::divide(dividend, divisor, result, 3, 1);
-		BOOST_CHECK_EQUAL(result[0], 0);
-		BOOST_CHECK_EQUAL(result[1], 128);
-		BOOST_CHECK_EQUAL(result[2], 0);
+		BOOST_CHECK_EQUAL(result[0], 0u);
+		BOOST_CHECK_EQUAL(result[1], 2147483648u);
+		BOOST_CHECK_EQUAL(result[2], 0u);
 	}
 	BOOST_AUTO_TEST_CASE(approximate_result) {
-		unsigned char dividend[] = {1, 0, 0, 0};
-		unsigned char divisor[] = {0, 3, 0, 0};
-		unsigned char result[] = {0, 0, 0, 0};
-		// result will represent 256 / 3 = 85.3333
+		array_arithmetic::limb dividend[] = {1, 0, 0, 0};
+		array_arithmetic::limb divisor[] = {0, 3, 0, 0};
+		array_arithmetic::limb result[] = {0, 0, 0, 0};
+		// result will represent 2 ^ 32 / 3 = 1431655765.3333
 		array_arithmetic::divide(dividend, divisor, result, 4, 1);
-		BOOST_CHECK_EQUAL(result[0], 85);
-		// 85 infinitely repeating is the representation of 1 / 3 in base 256
-		BOOST_CHECK_EQUAL(result[1], 85);
-		BOOST_CHECK_EQUAL(result[2], 85);
-		BOOST_CHECK_EQUAL(result[3], 85);
+		BOOST_CHECK_EQUAL(result[0], 1431655765u);
+		// 1431655765 (0x55555555) infinitely repeating is the representation of 1 / 3 in base 2 ^ 32
+		BOOST_CHECK_EQUAL(result[1], 1431655765u);
+		BOOST_CHECK_EQUAL(result[2], 1431655765u);
+		BOOST_CHECK_EQUAL(result[3], 1431655765u);
+	}
+	BOOST_AUTO_TEST_CASE(add_back_step) {
+		// the first estimate of the last quotient limb is 1 too large, which
+		// only shows after multiplying it with the whole divisor
+		array_arithmetic::limb dividend[] = {0, 0, 2147483647u};
+		array_arithmetic::limb divisor[] = {1, 0, 1};
+		array_arithmetic::limb result[] = {0, 0, 0};
+		array_arithmetic::divide(dividend, divisor, result, 3, 1);
+		BOOST_CHECK_EQUAL(result[0], 0u);
+		BOOST_CHECK_EQUAL(result[1], 0u);
+		BOOST_CHECK_EQUAL(result[2], 2147483646u);
+		dividend[2] = 2147483648u;
+		array_arithmetic::divide(dividend, divisor, result, 3, 1);
+		BOOST_CHECK_EQUAL(result[2], 2147483647u);
+	}
+	BOOST_AUTO_TEST_CASE(long_division) {
+		// (2^32 + 1) / (3 * 2^32 + 3) = 1 / 3 with 2 integer limbs
+		array_arithmetic::limb dividend[] = {1, 1, 0, 0, 0};
+		array_arithmetic::limb divisor[] = {3, 3, 0, 0, 0};
+		array_arithmetic::limb result[5];
+		array_arithmetic::divide(dividend, divisor, result, 5, 2);
+		BOOST_CHECK_EQUAL(result[0], 0u);
+		BOOST_CHECK_EQUAL(result[1], 0u);
+		for (std::size_t i = 2; i < 5; ++i) { BOOST_CHECK_EQUAL(result[i], 1431655765u); }
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+/**
+ * compares newton_divide against divide for a divisor with the given number of
+ * leading zero limbs, using the given fill or pseudo-random digits if fill is 0
+ * Both must give the same result or both must throw an overflow_error
+ */
+bool newton_matches_divide(const std::size_t& len, const std::size_t& int_digits,
+		const std::size_t& divisor_zeros, const array_arithmetic::limb& fill) {
+	array_arithmetic::limb* dividend = new array_arithmetic::limb[len];
+	array_arithmetic::limb* divisor = new array_arithmetic::limb[len];
+	array_arithmetic::limb* expected = new array_arithmetic::limb[len];
+	array_arithmetic::limb* actual = new array_arithmetic::limb[len];
+	std::size_t i;
+	for (i = 0; i < len; ++i) {
+		dividend[i] = fill == 0 ? random_limb() : fill;
+		divisor[i] = i < divisor_zeros ? 0 : (fill == 0 ? random_limb() : fill);
+	}
+	if (array_arithmetic::helpers::is_zero(divisor, len)) { divisor[len - 1] = 1; }
+	bool expected_overflow = false, actual_overflow = false;
+	try { array_arithmetic::divide(dividend, divisor, expected, len, int_digits); }
+	catch (std::overflow_error&) { expected_overflow = true; }
+	try { array_arithmetic::newton_divide(dividend, divisor, actual, len, int_digits); }
+	catch (std::overflow_error&) { actual_overflow = true; }
+	bool result = expected_overflow == actual_overflow;
+	for (i = 0; result && !expected_overflow && i < len; ++i) {
+		if (expected[i] != actual[i]) { result = false; }
+	}
+	delete[] dividend;
+	delete[] divisor;
+	delete[] expected;
+	delete[] actual;
+	return result;
+}
+
+struct NewtonDivisionCases {
+	NewtonDivisionCases() { std::srand(1); }
+};
+
+BOOST_FIXTURE_TEST_SUITE(newton_division, NewtonDivisionCases)
+	BOOST_AUTO_TEST_CASE(divide_by_zero) {
+		array_arithmetic::limb divisor[] = {0, 0, 0};
+		array_arithmetic::limb dividend[] = {1, 1, 1};
+		array_arithmetic::limb result[] = {129, 129, 129};
+		BOOST_CHECK_THROW(array_arithmetic::newton_divide(dividend, divisor, result, 3, 1), std::invalid_argument);
+	}
+	BOOST_AUTO_TEST_CASE(result_too_big) {
+		array_arithmetic::limb dividend[] = {2147483648u, 0};
+		array_arithmetic::limb divisor[] = {0, 2147483648u};
+		array_arithmetic::limb result[] = {0, 0};
+		BOOST_CHECK_THROW(array_arithmetic::newton_divide(dividend, divisor, result, 2, 1), std::overflow_error);
+	}
+	BOOST_AUTO_TEST_CASE(approximate_result) {
+		array_arithmetic::limb dividend[] = {1, 0, 0, 0};
+		array_arithmetic::limb divisor[] = {0, 3, 0, 0};
+		array_arithmetic::limb result[] = {0, 0, 0, 0};
+		array_arithmetic::newton_divide(dividend, divisor, result, 4, 1);
+		BOOST_CHECK_EQUAL(result[0], 1431655765u);
+		BOOST_CHECK_EQUAL(result[1], 1431655765u);
+		BOOST_CHECK_EQUAL(result[2], 1431655765u);
+		BOOST_CHECK_EQUAL(result[3], 1431655765u);
+	}
+	BOOST_AUTO_TEST_CASE(matches_divide) {
+		for (std::size_t len = 1; len < 30; ++len) {
+			for (std::size_t zeros = 0; zeros < len; zeros += 2) {
+				BOOST_CHECK(newton_matches_divide(len, 1, zeros, 0));
+				BOOST_CHECK(newton_matches_divide(len, len / 2, zeros, 0));
+			}
+		}
+	}
+	BOOST_AUTO_TEST_CASE(maximum_digits) {
+		BOOST_CHECK(newton_matches_divide(20, 1, 0, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(newton_matches_divide(20, 1, 1, array_arithmetic::RADIX_MINUS_ONE));
+		BOOST_CHECK(newton_matches_divide(41, 1, 1, array_arithmetic::RADIX_MINUS_ONE));
+		// powers of 2 are exact reciprocals
+		BOOST_CHECK(newton_matches_divide(20, 1, 3, 2147483648u));
+		BOOST_CHECK(newton_matches_divide(33, 1, 1, 1));
+	}
+	BOOST_AUTO_TEST_CASE(karatsuba_lengths) {
+		BOOST_CHECK(newton_matches_divide(100, 1, 0, 0));
+		BOOST_CHECK(newton_matches_divide(100, 1, 37, 0));
+		BOOST_CHECK(newton_matches_divide(150, 1, 99, 0));
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(workspace)
+	BOOST_AUTO_TEST_CASE(allocate_and_release) {
+		array_arithmetic::Workspace ws;
+		BOOST_CHECK_EQUAL(ws.get_capacity(), static_cast<std::size_t>(0));
+		array_arithmetic::Workspace::Mark mark = ws.get_mark();
+		array_arithmetic::limb* first = ws.allocate(10);
+		array_arithmetic::limb* second = ws.allocate(20);
+		BOOST_CHECK(second == first + 10);
+		BOOST_CHECK_EQUAL(ws.get_in_use(), static_cast<std::size_t>(30));
+		ws.release(mark);
+		BOOST_CHECK_EQUAL(ws.get_in_use(), static_cast<std::size_t>(0));
+		BOOST_CHECK_EQUAL(ws.get_peak(), static_cast<std::size_t>(30));
+		// memory is reused after release
+		BOOST_CHECK(ws.allocate(5) == first);
+	}
+	BOOST_AUTO_TEST_CASE(frame) {
+		array_arithmetic::Workspace ws(100);
+		ws.allocate(5);
+		{
+			array_arithmetic::Workspace::Frame frame(ws);
+			ws.allocate(50);
+			BOOST_CHECK_EQUAL(ws.get_in_use(), static_cast<std::size_t>(55));
+		}
+		BOOST_CHECK_EQUAL(ws.get_in_use(), static_cast<std::size_t>(5));
+		BOOST_CHECK_EQUAL(ws.get_peak(), static_cast<std::size_t>(55));
+		ws.reset_peak();
+		BOOST_CHECK_EQUAL(ws.get_peak(), static_cast<std::size_t>(5));
+	}
+	BOOST_AUTO_TEST_CASE(growth) {
+		array_arithmetic::Workspace ws(100);
+		array_arithmetic::Workspace::Mark mark = ws.get_mark();
+		array_arithmetic::limb* small = ws.allocate(60);
+		// doesn't fit in the first block
+		array_arithmetic::limb* large = ws.allocate(5000);
+		large[4999] = 1;
+		small[59] = 2;
+		BOOST_CHECK_EQUAL(large[4999], 1u);
+		std::size_t capacity = ws.get_capacity();
+		BOOST_CHECK(capacity >= 5100);
+		ws.release(mark);
+		// once grown, the same allocations don't need more blocks
+		ws.allocate(60);
+		ws.allocate(5000);
+		BOOST_CHECK_EQUAL(ws.get_capacity(), capacity);
+	}
+	BOOST_AUTO_TEST_CASE(explicit_workspace) {
+		const std::size_t LEN = 200;
+		array_arithmetic::Workspace ws;
+		array_arithmetic::limb* a = new array_arithmetic::limb[LEN];
+		array_arithmetic::limb* b = new array_arithmetic::limb[LEN];
+		array_arithmetic::limb* expected = new array_arithmetic::limb[2 * LEN + 1];
+		array_arithmetic::limb* actual = new array_arithmetic::limb[2 * LEN + 1];
+		std::srand(1);
+		for (std::size_t i = 0; i < LEN; ++i) {
+			a[i] = random_limb();
+			b[i] = random_limb();
+		}
+		array_arithmetic::school_multiply(a, b, expected, LEN, LEN);
+		array_arithmetic::karatsuba_multiply(a, b, actual, LEN, LEN, ws);
+		bool same = true;
+		for (std::size_t i = 0; i < 2 * LEN + 1; ++i) {
+			if (expected[i] != actual[i]) { same = false; }
+		}
+		BOOST_CHECK(same);
+		BOOST_CHECK(ws.get_peak() > 0);
+		// everything is released when the call returns
+		BOOST_CHECK_EQUAL(ws.get_in_use(), static_cast<std::size_t>(0));
+		std::size_t multiply_peak = ws.get_peak();
+		array_arithmetic::divide(a, b, actual, LEN, 1, ws);
+		BOOST_CHECK(ws.get_peak() >= 2 * LEN);
+		BOOST_CHECK(ws.get_peak() >= multiply_peak);
+		BOOST_CHECK_EQUAL(ws.get_in_use(), static_cast<std::size_t>(0));
+		delete[] a;
+		delete[] b;
+		delete[] expected;
+		delete[] actual;
+	}
+	BOOST_AUTO_TEST_CASE(release_on_exception) {
+		array_arithmetic::Workspace ws;
+		array_arithmetic::limb dividend[] = {2147483648u, 0};
+		array_arithmetic::limb divisor[] = {0, 2147483648u};
+		array_arithmetic::limb result[] = {0, 0};
+		BOOST_CHECK_THROW(array_arithmetic::divide(dividend, divisor, result, 2, 1, ws), std::overflow_error);
+		BOOST_CHECK_EQUAL(ws.get_in_use(), static_cast<std::size_t>(0));
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+/**
+ * several threads, more than the processor may have, and a parallel threshold
+ * low enough that small arrays are split into tasks on every tier
+ */
+struct ParallelThreads : MultiplyThresholds {
+	std::size_t original_threads;
+	std::size_t original_parallel;
+	ParallelThreads() {
+		original_threads = array_arithmetic::get_thread_count();
+		original_parallel = array_arithmetic::parallel_threshold;
+		array_arithmetic::set_thread_count(4);
+		array_arithmetic::parallel_threshold = 8;
+	}
+	~ParallelThreads() {
+		array_arithmetic::set_thread_count(original_threads);
+		array_arithmetic::parallel_threshold = original_parallel;
+	}
+};
+
+BOOST_FIXTURE_TEST_SUITE(parallel, ParallelThreads)
+	BOOST_AUTO_TEST_CASE(task_group) {
+		std::atomic<std::size_t> count(0);
+		array_arithmetic::TaskGroup group;
+		for (std::size_t i = 0; i < 100; ++i) {
+			// nested tasks
+			group.run([&count] {
+				array_arithmetic::TaskGroup inner;
+				for (std::size_t j = 0; j < 10; ++j) { inner.run([&count] { ++count; }); }
+				inner.wait();
+			});
+		}
+		group.wait();
+		BOOST_CHECK_EQUAL(count.load(), static_cast<std::size_t>(1000));
+		// the first exception reaches wait(), after all tasks have finished
+		group.run([] { throw std::invalid_argument("task"); });
+		group.run([&count] { ++count; });
+		BOOST_CHECK_THROW(group.wait(), std::invalid_argument);
+		BOOST_CHECK_EQUAL(count.load(), static_cast<std::size_t>(1001));
+		group.wait();
+	}
+	BOOST_AUTO_TEST_CASE(thread_count) {
+		BOOST_CHECK_EQUAL(array_arithmetic::get_thread_count(), static_cast<std::size_t>(4));
+		array_arithmetic::set_thread_count(0);
+		BOOST_CHECK_EQUAL(array_arithmetic::get_thread_count(), static_cast<std::size_t>(1));
+		// a single thread runs tasks right away
+		bool done = false;
+		array_arithmetic::TaskGroup group;
+		group.run([&done] { done = true; });
+		BOOST_CHECK(done);
+		group.wait();
+	}
+	BOOST_AUTO_TEST_CASE(concurrent_products) {
+		std::size_t a_len, b_len;
+		for (a_len = 8; a_len < 120; a_len += 13) {
+			for (b_len = a_len / 2 + 1; b_len <= a_len; b_len += 7) {
+				BOOST_CHECK(product_matches_school(array_arithmetic::karatsuba_multiply, a_len, b_len, 0));
+				BOOST_CHECK(product_matches_school(array_arithmetic::toom3_multiply, a_len, b_len, 0));
+				BOOST_CHECK(product_matches_school(array_arithmetic::toom4_multiply, a_len, b_len, 0));
+				BOOST_CHECK(product_matches_school(array_arithmetic::ntt_multiply, a_len, b_len, 0));
+			}
+		}
+		BOOST_CHECK(product_matches_school(array_arithmetic::multiply, 700, 650, 0));
+		BOOST_CHECK(product_matches_school(array_arithmetic::ntt_multiply, 1000, 999,
+				array_arithmetic::RADIX_MINUS_ONE));
+	}
+	BOOST_AUTO_TEST_CASE(concurrent_squares) {
+		for (std::size_t len = 8; len < 120; len += 11) {
+			BOOST_CHECK(square_matches_school(array_arithmetic::karatsuba_square, len, 0));
+			BOOST_CHECK(square_matches_school(array_arithmetic::toom3_square, len, 0));
+			BOOST_CHECK(square_matches_school(array_arithmetic::toom4_square, len, 0));
+			BOOST_CHECK(square_matches_school(array_arithmetic::ntt_square, len, 0));
+		}
+		BOOST_CHECK(square_matches_school(array_arithmetic::square, 700, array_arithmetic::RADIX_MINUS_ONE));
 	}
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,167 @@
+/**
+ * Test Suite for BigInteger class
+ * command for running tests:
+ * ./big_integer_test --log_level=test_suite
+ *
+ * Copyright (c) 2012 Marshall Farrier
+ * license http://opensource.org/licenses/gpl-license.php GNU Public License
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+#include <climits>
+#include <string>
+#include <stdexcept>
+#include <utility>
+#include "big_integer.h"
+#include "real_number.h"
+
+struct BigIntegerTestCases {
+	std::string a_str;
+	std::string b_str;
+	// a * b, b / a and b % a
+	std::string product_str;
+	std::string quotient_str;
+	std::string remainder_str;
+
+	BigInteger zero;
+	BigInteger one;
+	BigInteger a;
+	BigInteger b;
+
+	BigIntegerTestCases() {
+		a_str = "123456789012345678901234567890";
+		b_str = "987654321098765432109876543210";
+		product_str = "121932631137021795226185032733622923332237463801111263526900";
+		quotient_str = "8";
+		remainder_str = "9000000000900000000090";
+		one = BigInteger(1);
+		a = BigInteger(a_str);
+		b = BigInteger(b_str);
+	}
+};
+
+BOOST_FIXTURE_TEST_SUITE(constructor, BigIntegerTestCases)
+	BOOST_AUTO_TEST_CASE(from_long_long) {
+		BOOST_CHECK_EQUAL(zero.to_decimal_string(), "0");
+		BOOST_CHECK(zero.is_zero() && !zero.is_negative());
+		BOOST_CHECK_EQUAL(BigInteger(-42).to_decimal_string(), "-42");
+		BOOST_CHECK_EQUAL(BigInteger(LLONG_MAX).to_decimal_string(), "9223372036854775807");
+		BOOST_CHECK_EQUAL(BigInteger(LLONG_MIN).to_decimal_string(), "-9223372036854775808");
+		BOOST_CHECK_EQUAL(BigInteger(4294967296ll).size(), static_cast<std::size_t>(2));
+	}
+	BOOST_AUTO_TEST_CASE(from_string) {
+		BOOST_CHECK_EQUAL(a.to_decimal_string(), a_str);
+		BOOST_CHECK_EQUAL(BigInteger("-" + b_str).to_decimal_string(), "-" + b_str);
+		BOOST_CHECK(BigInteger("-0") == zero);
+		BOOST_CHECK(BigInteger("000042") == BigInteger(42));
+		BOOST_CHECK_THROW(BigInteger(""), std::invalid_argument);
+		BOOST_CHECK_THROW(BigInteger("-"), std::invalid_argument);
+		BOOST_CHECK_THROW(BigInteger("12a"), std::invalid_argument);
+	}
+	BOOST_AUTO_TEST_CASE(move) {
+		BigInteger moved(std::move(a));
+		BOOST_CHECK_EQUAL(moved.to_decimal_string(), a_str);
+		BOOST_CHECK(a.is_zero());
+		b = -b;
+		a = std::move(b);
+		BOOST_CHECK_EQUAL(a.to_decimal_string(), "-" + b_str);
+		BOOST_CHECK(b.is_zero() && !b.is_negative());
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(arithmetic_operators, BigIntegerTestCases)
+	BOOST_AUTO_TEST_CASE(addition_and_subtraction) {
+		BOOST_CHECK_EQUAL((a + b).to_decimal_string(), "1111111110111111111011111111100");
+		BOOST_CHECK_EQUAL((a - b).to_decimal_string(), "-864197532086419753208641975320");
+		BOOST_CHECK_EQUAL((b - a).to_decimal_string(), "864197532086419753208641975320");
+		BOOST_CHECK_EQUAL((-a - b).to_decimal_string(), "-1111111110111111111011111111100");
+		BOOST_CHECK(a - a == zero);
+		BOOST_CHECK(!(a - a).is_negative());
+		// carry into a new limb and borrow out of the leading one
+		BigInteger radix(4294967296ll);
+		BOOST_CHECK(BigInteger(4294967295ll) + one == radix);
+		BOOST_CHECK_EQUAL((radix - one).size(), static_cast<std::size_t>(1));
+		// operands that are the same object
+		BigInteger x(a);
+		x += x;
+		BOOST_CHECK(x == a + a);
+		x -= x;
+		BOOST_CHECK(x == zero);
+	}
+	BOOST_AUTO_TEST_CASE(multiplication) {
+		BOOST_CHECK_EQUAL((a * b).to_decimal_string(), product_str);
+		BOOST_CHECK_EQUAL((-a * b).to_decimal_string(), "-" + product_str);
+		BOOST_CHECK((-a * -b) == a * b);
+		BOOST_CHECK(a * zero == zero);
+		BigInteger x(a);
+		x *= x;
+		BOOST_CHECK(x == a * a);
+		x = a;
+		x *= static_cast<array_arithmetic::limb>(1000);
+		BOOST_CHECK_EQUAL(x.to_decimal_string(), a_str + "000");
+	}
+	BOOST_AUTO_TEST_CASE(division) {
+		BOOST_CHECK_EQUAL((b / a).to_decimal_string(), quotient_str);
+		BOOST_CHECK_EQUAL((b % a).to_decimal_string(), remainder_str);
+		// truncated toward 0, as for int
+		BOOST_CHECK_EQUAL((-b / a).to_decimal_string(), "-" + quotient_str);
+		BOOST_CHECK_EQUAL((-b % a).to_decimal_string(), "-" + remainder_str);
+		BOOST_CHECK_EQUAL((b / -a).to_decimal_string(), "-" + quotient_str);
+		BOOST_CHECK_EQUAL((b % -a).to_decimal_string(), remainder_str);
+		BOOST_CHECK(a / b == zero);
+		BOOST_CHECK(a % b == a);
+		BOOST_CHECK((a * b) / a == b);
+		BOOST_CHECK_THROW(a / zero, std::invalid_argument);
+		BOOST_CHECK_THROW(a % zero, std::invalid_argument);
+	}
+	BOOST_AUTO_TEST_CASE(long_division) {
+		// long enough for newton_divide()
+		BigInteger dividend(3), divisor(7);
+		for (std::size_t i = 0; i < 16; ++i) { dividend *= dividend; }
+		for (std::size_t i = 0; i < 10; ++i) { divisor *= divisor; }
+		dividend += a;
+		BOOST_CHECK(dividend.size() > array_arithmetic::NEWTON_DIVISION_THRESHOLD);
+		BigInteger quotient = dividend / divisor;
+		BigInteger remainder = dividend % divisor;
+		BOOST_CHECK(quotient * divisor + remainder == dividend);
+		BOOST_CHECK(!remainder.is_negative() && remainder < divisor);
+		BOOST_CHECK((dividend * divisor) / divisor == dividend);
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(comparison_operators, BigIntegerTestCases)
+	BOOST_AUTO_TEST_CASE(ordering) {
+		BOOST_CHECK(a < b);
+		BOOST_CHECK(-b < -a);
+		BOOST_CHECK(-a < zero && zero < a);
+		BOOST_CHECK(a <= a && a >= a);
+		BOOST_CHECK(b > a && !(a > b));
+		BOOST_CHECK(a != -a);
+		BOOST_CHECK(a == BigInteger(a_str));
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(real_number_conversion, BigIntegerTestCases)
+	BOOST_AUTO_TEST_CASE(to_real_number) {
+		BOOST_CHECK(BigInteger(3).to_real_number(0) == RealNumber("3.0"));
+		// 3 / RADIX^1, with any precision
+		BOOST_CHECK(BigInteger(3).to_real_number(1, 2) * RealNumber::from_double(4294967296.0 / 2, 2)
+				== RealNumber("1.5", 2));
+		// b / 10^30 in 2 ways
+		BigInteger scale(1);
+		for (std::size_t i = 0; i < 30; ++i) { scale *= static_cast<array_arithmetic::limb>(10); }
+		BOOST_CHECK(RealNumber(b.to_real_number(scale.size()) / scale.to_real_number(scale.size())).equals(
+				RealNumber("0.98765432109876543210987654321")));
+		BOOST_CHECK_THROW(b.to_real_number(1), std::invalid_argument);
+		BOOST_CHECK_THROW((-one).to_real_number(0), std::invalid_argument);
+	}
+	BOOST_AUTO_TEST_CASE(from_real_number) {
+		BOOST_CHECK(BigInteger::from_real_number(RealNumber("2.5", 1)) == BigInteger(5ll << 31));
+		BOOST_CHECK(BigInteger::from_real_number(RealNumber(7)) == zero);
+		// exact in both directions
+		RealNumber third = RealNumber("1.0", 20) / RealNumber("3.0", 20);
+		BOOST_CHECK(BigInteger::from_real_number(third).to_real_number(20, 20) == third);
+	}
+BOOST_AUTO_TEST_SUITE_END()
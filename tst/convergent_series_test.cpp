@@ -0,0 +1,318 @@
+/**
+ * Test Suite for ConvergentSeries namespace methods and for
+ * the allocation behavior of the RealNumber operations they use
+ * command for running tests:
+ * ./convergent_series_test --log_level=test_suite
+ *
+ * Copyright (c) 2012 Marshall Farrier
+ * license http://opensource.org/licenses/gpl-license.php GNU Public License
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "convergent_series.h"
+#include "real_number.h"
+
+/**
+ * global allocation counter
+ * operator new is replaced for the whole test executable, so that
+ * allocations can be counted between 2 points of a test
+ */
+namespace {
+	// atomic, since worker threads of the parallel tests allocate too
+	std::atomic<std::size_t> allocation_count(0);
+}
+
+void* operator new(std::size_t size) {
+	++allocation_count;
+	void* result = std::malloc(size == 0 ? 1 : size);
+	if (result == 0) { throw std::bad_alloc(); }
+	return result;
+}
+void* operator new[](std::size_t size) {
+	++allocation_count;
+	void* result = std::malloc(size == 0 ? 1 : size);
+	if (result == 0) { throw std::bad_alloc(); }
+	return result;
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+struct SeriesTestCases {
+	RealNumber one;
+	RealNumber two;
+	RealNumber one_half;
+	RealNumber sqrt_two_guess;
+	// sqrt(2) to 120 decimal places
+	std::string sqrt_two_str;
+	SeriesTestCases() {
+		one = RealNumber("1.0");
+		two = RealNumber("2.0");
+		one_half = RealNumber("0.5");
+		sqrt_two_guess = RealNumber("1.4");
+		sqrt_two_str = "1.41421356237309504880168872420969807856967187537694807317667973799073247846"
+				"2107038850387534327641572735013846230912297024";
+	}
+};
+
+BOOST_FIXTURE_TEST_SUITE(series, SeriesTestCases)
+	BOOST_AUTO_TEST_CASE(babylonian_sqrt) {
+		RealNumber sqrt_two = ConvergentSeries::babylonian_sqrt(two, sqrt_two_guess, 10);
+		BOOST_CHECK_EQUAL(sqrt_two.to_decimal_string().substr(0, sqrt_two_str.size()), sqrt_two_str);
+	}
+	BOOST_AUTO_TEST_CASE(sqrt) {
+		RealNumber sqrt_two = ConvergentSeries::sqrt(two);
+		BOOST_CHECK_EQUAL(sqrt_two.to_decimal_string().substr(0, sqrt_two_str.size()), sqrt_two_str);
+		BOOST_CHECK(ConvergentSeries::sqrt(RealNumber("9.0")).equals(RealNumber("3.0")));
+		BOOST_CHECK(ConvergentSeries::sqrt(RealNumber()) == RealNumber());
+		// precisions that aren't powers of 2
+		const std::size_t LIMBS[] = {1, 3, 50, 123};
+		for (std::size_t i = 0; i < sizeof(LIMBS) / sizeof(LIMBS[0]); ++i) {
+			RealNumber num("123.456", LIMBS[i]);
+			RealNumber root = ConvergentSeries::sqrt(num);
+			BOOST_CHECK_EQUAL(root.get_precision(), LIMBS[i]);
+			BOOST_CHECK(root.equals(ConvergentSeries::babylonian_sqrt(num, RealNumber("11.0", LIMBS[i]), 30)));
+		}
+		// within and below the range of double
+		RealNumber small("0.000000000000000000000000000000000000000001", 50);
+		RealNumber root = ConvergentSeries::sqrt(small);
+		BOOST_CHECK(root.square().equals(small));
+		BOOST_CHECK_EQUAL(root.to_decimal_string().substr(0, 25), "0.00000000000000000000099");
+		RealNumber tiny(small * small * small * small * small * small * small * small);
+		BOOST_CHECK(ConvergentSeries::sqrt(tiny).square().equals(tiny));
+	}
+	BOOST_AUTO_TEST_CASE(sqrt_without_guess) {
+		// the division-free and the babylonian forms agree
+		const std::size_t LIMBS[] = {1, 2, 13, 64, 200};
+		const char* NUMS[] = {"2.0", "0.0001", "300000000.0", "1.0"};
+		for (std::size_t i = 0; i < sizeof(LIMBS) / sizeof(LIMBS[0]); ++i) {
+			for (std::size_t j = 0; j < sizeof(NUMS) / sizeof(NUMS[0]); ++j) {
+				RealNumber num(NUMS[j], LIMBS[i]);
+				RealNumber root = ConvergentSeries::babylonian_sqrt(num);
+				BOOST_CHECK(root.equals(ConvergentSeries::sqrt(num)));
+				// squaring multiplies the error of larger roots beyond the tolerance
+				if (j != 2) { BOOST_CHECK(root.square().equals(num)); }
+			}
+		}
+		BOOST_CHECK_EQUAL(ConvergentSeries::babylonian_sqrt(two).to_decimal_string().substr(0, sqrt_two_str.size()),
+				sqrt_two_str);
+		BOOST_CHECK(ConvergentSeries::babylonian_sqrt(RealNumber()) == RealNumber());
+	}
+	BOOST_AUTO_TEST_CASE(inv_sqrt) {
+		BOOST_CHECK(ConvergentSeries::inv_sqrt(RealNumber("4.0")).equals(one_half));
+		BOOST_CHECK(ConvergentSeries::inv_sqrt(RealNumber("0.25")).equals(two));
+		const std::size_t LIMBS = 100;
+		RealNumber num("2.0", LIMBS);
+		RealNumber y = ConvergentSeries::inv_sqrt(num);
+		BOOST_CHECK_EQUAL(y.get_precision(), LIMBS);
+		BOOST_CHECK(RealNumber(num * y * y).equals(RealNumber("1.0", LIMBS)));
+		// 1 / sqrt(num) must fit in the integer limb
+		BOOST_CHECK_THROW(ConvergentSeries::inv_sqrt(RealNumber()), std::invalid_argument);
+		BOOST_CHECK_THROW(ConvergentSeries::inv_sqrt(RealNumber("0.0000000000000000000001")), std::invalid_argument);
+	}
+	BOOST_AUTO_TEST_CASE(gauss_legendre_pi_without_division) {
+		const std::string PI_STR = "3.14159265358979323846264338327950288419716939937510582097494459230781640628"
+				"62089986280348253421170679821480865132823066470938446095505822317253594081284811174502841027";
+		RealNumber pi = ConvergentSeries::gauss_legendre_pi(7, RealNumber::precision_for_digits(PI_STR.size()));
+		BOOST_CHECK_EQUAL(pi.to_decimal_string().substr(0, PI_STR.size()), PI_STR);
+		RealNumber sqrt_two = ConvergentSeries::sqrt(two);
+		BOOST_CHECK(ConvergentSeries::gauss_legendre_pi(6, RealNumber::PRECISION).equals(
+				ConvergentSeries::gauss_legendre_pi(6, 10, sqrt_two)));
+	}
+	BOOST_AUTO_TEST_CASE(chudnovsky_pi) {
+		const std::string PI_STR = "3.14159265358979323846264338327950288419716939937510582097494459230781640628"
+				"62089986280348253421170679821480865132823066470938446095505822317253594081284811174502841027";
+		RealNumber pi = ConvergentSeries::chudnovsky_pi(RealNumber::precision_for_digits(PI_STR.size()));
+		BOOST_CHECK_EQUAL(pi.to_decimal_string().substr(0, PI_STR.size()), PI_STR);
+		// a single term and the number of terms for higher precisions
+		BOOST_CHECK_EQUAL(ConvergentSeries::chudnovsky_pi(1).to_decimal_string().substr(0, 10), PI_STR.substr(0, 10));
+		const std::size_t LIMBS = 300;
+		pi = ConvergentSeries::chudnovsky_pi(LIMBS);
+		BOOST_CHECK_EQUAL(pi.get_precision(), LIMBS);
+		BOOST_CHECK(pi.equals(RealNumber(ConvergentSeries::chudnovsky_pi(LIMBS + 10), LIMBS)));
+	}
+	BOOST_AUTO_TEST_CASE(binary_splitting) {
+		// sum 2^(-k) for k < 10: t(k) = 1, p(k) = 1, q(0) = 1 and q(k) = 2
+		ConvergentSeries::SeriesTerms terms;
+		terms.p = [](const std::size_t&) { return BigInteger(1); };
+		terms.q = [](const std::size_t& k) { return BigInteger(k == 0 ? 1 : 2); };
+		terms.t = terms.p;
+		BigInteger q, t;
+		ConvergentSeries::binary_splitting(terms, 10, q, t);
+		BOOST_CHECK(q == BigInteger(512));
+		BOOST_CHECK(t == BigInteger(1023));
+		ConvergentSeries::binary_splitting(terms, 1, q, t);
+		BOOST_CHECK(q == BigInteger(1) && t == BigInteger(1));
+	}
+	BOOST_AUTO_TEST_CASE(e) {
+		const std::string E_STR = "2.71828182845904523536028747135266249775724709369995957496696762772407663035"
+				"35475945713821785251664274274663919320030599218174135966290435729003342952605956307381";
+		RealNumber e = ConvergentSeries::e(RealNumber::precision_for_digits(E_STR.size()));
+		BOOST_CHECK_EQUAL(e.to_decimal_string().substr(0, E_STR.size()), E_STR);
+		BOOST_CHECK_EQUAL(ConvergentSeries::e(1).to_decimal_string().substr(0, 10), E_STR.substr(0, 10));
+	}
+	BOOST_AUTO_TEST_CASE(parallel_binary_splitting) {
+		const std::size_t LIMBS = 300;
+		const RealNumber pi = ConvergentSeries::chudnovsky_pi(LIMBS);
+		const RealNumber e = ConvergentSeries::e(LIMBS);
+		const std::size_t ORIGINAL_THREADS = array_arithmetic::get_thread_count();
+		const std::size_t ORIGINAL_PARALLEL = array_arithmetic::parallel_threshold;
+		const std::size_t ORIGINAL_DEPTH = ConvergentSeries::splitting_serial_depth;
+		// more threads than the processor may have, and concurrent products too
+		array_arithmetic::set_thread_count(4);
+		array_arithmetic::parallel_threshold = 16;
+		for (std::size_t depth = 0; depth < 12; depth += 3) {
+			ConvergentSeries::splitting_serial_depth = depth;
+			BOOST_CHECK(ConvergentSeries::chudnovsky_pi(LIMBS) == pi);
+			BOOST_CHECK(ConvergentSeries::e(LIMBS) == e);
+		}
+		array_arithmetic::set_thread_count(ORIGINAL_THREADS);
+		array_arithmetic::parallel_threshold = ORIGINAL_PARALLEL;
+		ConvergentSeries::splitting_serial_depth = ORIGINAL_DEPTH;
+	}
+	BOOST_AUTO_TEST_CASE(concurrent_gauss_legendre_pi) {
+		const std::size_t LIMBS = 100;
+		const RealNumber sqrt_two = ConvergentSeries::babylonian_sqrt(RealNumber("2.0", LIMBS),
+				RealNumber("1.4", LIMBS), 12);
+		const RealNumber pi = ConvergentSeries::gauss_legendre_pi(9, 12, sqrt_two);
+		const RealNumber division_free_pi = ConvergentSeries::gauss_legendre_pi(9, LIMBS);
+		const std::size_t ORIGINAL_THREADS = array_arithmetic::get_thread_count();
+		const std::size_t ORIGINAL_THRESHOLD = ConvergentSeries::task_graph_threshold;
+		array_arithmetic::set_thread_count(4);
+		ConvergentSeries::task_graph_threshold = 0;
+		for (std::size_t i = 0; i < 4; ++i) {
+			BOOST_CHECK(ConvergentSeries::gauss_legendre_pi(9, 12, sqrt_two) == pi);
+			BOOST_CHECK(ConvergentSeries::gauss_legendre_pi(9, LIMBS) == division_free_pi);
+		}
+		array_arithmetic::set_thread_count(ORIGINAL_THREADS);
+		ConvergentSeries::task_graph_threshold = ORIGINAL_THRESHOLD;
+		// accurate to all but the last few of the 963 digits
+		BOOST_CHECK_EQUAL(pi.to_decimal_string().substr(0, 950),
+				ConvergentSeries::chudnovsky_pi(LIMBS).to_decimal_string().substr(0, 950));
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(allocation, SeriesTestCases)
+	BOOST_AUTO_TEST_CASE(inline_temporaries) {
+		// the same kinds of statements as in the gauss_legendre_pi loop
+		RealNumber a(one), b(one_half), a_next, p(one);
+		std::size_t before = allocation_count;
+		for (std::size_t i = 0; i < 10; ++i) {
+			a_next = a + b;
+			RealNumber copy(a_next);
+			RealNumber moved(std::move(copy));
+			p = p + p;
+			a = std::move(moved);
+			b = a_next;
+		}
+		std::size_t allocations = allocation_count - before;
+		BOOST_CHECK_EQUAL(allocations, static_cast<std::size_t>(0));
+	}
+	BOOST_AUTO_TEST_CASE(heap_storage_is_moved) {
+		// precision too large for inline storage
+		const std::size_t LIMBS = 4 * RealNumber::INLINE_LIMBS;
+		RealNumber x("1.5", LIMBS);
+		std::size_t before = allocation_count;
+		RealNumber moved(std::move(x));
+		RealNumber y(LIMBS);
+		std::size_t after_construction = allocation_count;
+		y = std::move(moved);
+		RealNumber z = y + y;
+		std::size_t allocations = allocation_count - before;
+		std::size_t allocations_after_construction = allocation_count - after_construction;
+		// 1 for y and 1 for z
+		BOOST_CHECK_EQUAL(allocations, static_cast<std::size_t>(2));
+		BOOST_CHECK_EQUAL(allocations_after_construction, static_cast<std::size_t>(1));
+		BOOST_CHECK(z == RealNumber("3.0", LIMBS));
+		BOOST_CHECK_EQUAL(x.get_precision(), static_cast<std::size_t>(0));
+	}
+	BOOST_AUTO_TEST_CASE(babylonian_sqrt_statement) {
+		RealNumber result(sqrt_two_guess);
+		// first division grows the thread-local workspace
+		result = (result + (two / result)) / two;
+		std::size_t before = allocation_count;
+		result = (result + (two / result)) / two;
+		std::size_t allocations = allocation_count - before;
+		BOOST_CHECK_EQUAL(allocations, static_cast<std::size_t>(0));
+	}
+	BOOST_AUTO_TEST_CASE(babylonian_sqrt_loop) {
+		ConvergentSeries::babylonian_sqrt(two, sqrt_two_guess, 1);
+		std::size_t before = allocation_count;
+		ConvergentSeries::babylonian_sqrt(two, sqrt_two_guess, 1);
+		std::size_t one_iteration = allocation_count - before;
+		before = allocation_count;
+		ConvergentSeries::babylonian_sqrt(two, sqrt_two_guess, 11);
+		std::size_t eleven_iterations = allocation_count - before;
+		// allocations outside of the loop are the same, so the loop allocates nothing
+		BOOST_CHECK_EQUAL(eleven_iterations, one_iteration);
+	}
+	BOOST_AUTO_TEST_CASE(gauss_legendre_pi_loop) {
+		RealNumber sqrt_two = ConvergentSeries::babylonian_sqrt(two, sqrt_two_guess, 10);
+		ConvergentSeries::gauss_legendre_pi(2, 10, sqrt_two);
+		std::size_t before = allocation_count;
+		ConvergentSeries::gauss_legendre_pi(2, 10, sqrt_two);
+		std::size_t two_iterations = allocation_count - before;
+		before = allocation_count;
+		ConvergentSeries::gauss_legendre_pi(5, 10, sqrt_two);
+		std::size_t five_iterations = allocation_count - before;
+		BOOST_CHECK_EQUAL(five_iterations, two_iterations);
+	}
+	BOOST_AUTO_TEST_CASE(division_free_pi_loop) {
+		const std::size_t LIMBS = 4 * RealNumber::INLINE_LIMBS;
+		ConvergentSeries::gauss_legendre_pi(2, LIMBS);
+		std::size_t before = allocation_count;
+		ConvergentSeries::gauss_legendre_pi(2, LIMBS);
+		std::size_t two_iterations = allocation_count - before;
+		before = allocation_count;
+		ConvergentSeries::gauss_legendre_pi(5, LIMBS);
+		std::size_t five_iterations = allocation_count - before;
+		BOOST_CHECK_EQUAL(five_iterations, two_iterations);
+	}
+	BOOST_AUTO_TEST_CASE(heap_precision_loops) {
+		// precision too large for inline storage
+		const std::size_t LIMBS = 4 * RealNumber::INLINE_LIMBS;
+		RealNumber sqrt_two = ConvergentSeries::babylonian_sqrt(RealNumber("2.0", LIMBS),
+				RealNumber("1.4", LIMBS), 10);
+		ConvergentSeries::gauss_legendre_pi(2, 10, sqrt_two);
+		std::size_t before = allocation_count;
+		ConvergentSeries::gauss_legendre_pi(2, 10, sqrt_two);
+		std::size_t two_iterations = allocation_count - before;
+		before = allocation_count;
+		RealNumber pi = ConvergentSeries::gauss_legendre_pi(5, 10, sqrt_two);
+		std::size_t five_iterations = allocation_count - before;
+		BOOST_CHECK_EQUAL(five_iterations, two_iterations);
+		BOOST_CHECK_EQUAL(pi.to_decimal_string().substr(0, 40), "3.14159265358979323846264338327950288419");
+	}
+	BOOST_AUTO_TEST_CASE(in_place_statements) {
+		const std::size_t LIMBS = 4 * RealNumber::INLINE_LIMBS;
+		RealNumber x("1.5", LIMBS), y("0.75", LIMBS), result(LIMBS);
+		// grows the thread-local workspace
+		div(result, x, y);
+		std::size_t before = allocation_count;
+		add(result, x, y);
+		sub(result, result, y);
+		mul(result, result, x);
+		mul(result, result, result);
+		div(result, result, y);
+		result += x;
+		result -= y;
+		result *= y;
+		result /= x;
+		// expressions are evaluated in scratch memory
+		result = x - y * (result * result);
+		result = (x + result) * y;
+		result += x * y - result * y;
+		std::size_t allocations = allocation_count - before;
+		BOOST_CHECK_EQUAL(allocations, static_cast<std::size_t>(0));
+	}
+BOOST_AUTO_TEST_SUITE_END()
@@ -14,6 +14,8 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MAIN
 #include <boost/test/unit_test.hpp>
+#include <cfloat>
+#include <cmath>
 #include <string>
 #include <stdexcept>
 #include "real_number.h"
@@ -202,6 +204,31 @@ BOOST_FIXTURE_TEST_SUITE(arithmetic_operators, RealNumberTestCases)
 		BOOST_CHECK(two_rn * very_small_num_rn > very_small_num_rn);
 	}
 
+	BOOST_AUTO_TEST_CASE(square) {
+		BOOST_CHECK(two_rn.square() == RealNumber("4.0"));
+		BOOST_CHECK(zero_rn.square() == zero_rn);
+		BOOST_CHECK(two_plus_small_rn.square().equals(two_plus_small_rn * RealNumber(two_plus_small_rn)));
+		BOOST_CHECK(two_plus_small_rn * two_plus_small_rn == two_plus_small_rn.square());
+		RealNumber third = RealNumber(one_str, 300) / RealNumber("3.0", 300);
+		BOOST_CHECK(third.square().equals(third * RealNumber(third)));
+		BOOST_CHECK_EQUAL(third.square().get_precision(), static_cast<std::size_t>(300));
+	}
+
+	BOOST_AUTO_TEST_CASE(short_product) {
+		// the short product is at most 1 below the truncated exact product
+		const std::size_t LIMBS = 60;
+		RealNumber third = RealNumber(one_str, LIMBS) / RealNumber("3.0", LIMBS);
+		RealNumber seventh = RealNumber(one_str, LIMBS) / RealNumber("7.0", LIMBS);
+		RealNumber product = third * seventh;
+		RealNumber exact(RealNumber(third, 2 * LIMBS) * RealNumber(seventh, 2 * LIMBS), LIMBS);
+		// 1 in the last limb
+		RealNumber last_limb(one_str, LIMBS);
+		for (std::size_t i = 0; i < 2 * LIMBS; ++i) { last_limb = last_limb / RealNumber("65536.0", LIMBS); }
+		BOOST_CHECK(product <= exact);
+		BOOST_CHECK(exact - product <= last_limb);
+		BOOST_CHECK(product.equals(exact));
+	}
+
 	BOOST_AUTO_TEST_CASE(division) {
 		BOOST_CHECK(one_rn / two_rn < RealNumber("0.50000001"));
 		BOOST_CHECK(one_rn / two_rn > RealNumber("0.49999999"));
@@ -211,6 +238,124 @@ BOOST_FIXTURE_TEST_SUITE(arithmetic_operators, RealNumberTestCases)
 	}
 BOOST_AUTO_TEST_SUITE_END()
 
+BOOST_FIXTURE_TEST_SUITE(in_place_arithmetic, RealNumberTestCases)
+	BOOST_AUTO_TEST_CASE(compound_assignment) {
+		RealNumber x(two_plus_small_rn);
+		x += one_rn;
+		BOOST_CHECK(x == two_plus_small_rn + one_rn);
+		x -= two_rn;
+		BOOST_CHECK(x == two_plus_small_rn + one_rn - two_rn);
+		x *= big_num_rn;
+		BOOST_CHECK(x == (two_plus_small_rn + one_rn - two_rn) * big_num_rn);
+		x /= big_num_rn;
+		BOOST_CHECK(x.equals(two_plus_small_rn + one_rn - two_rn));
+		BOOST_CHECK_THROW(x /= zero_rn, std::invalid_argument);
+	}
+	BOOST_AUTO_TEST_CASE(aliasing) {
+		RealNumber x(two_plus_small_rn);
+		x *= x;
+		BOOST_CHECK(x == two_plus_small_rn.square());
+		x /= x;
+		BOOST_CHECK(x == one_rn);
+		x += x;
+		BOOST_CHECK(x == two_rn);
+		x -= x;
+		BOOST_CHECK(x == zero_rn);
+		RealNumber y(small_num_rn);
+		div(y, one_rn, y);
+		BOOST_CHECK(y == one_rn / small_num_rn);
+		mul(y, small_num_rn, y);
+		BOOST_CHECK(y.equals(one_rn));
+	}
+	BOOST_AUTO_TEST_CASE(result_precision) {
+		RealNumber result;
+		RealNumber one_high(one_str, 30);
+		RealNumber three_high("3.0", 30);
+		div(result, one_high, three_high);
+		BOOST_CHECK_EQUAL(result.get_precision(), static_cast<std::size_t>(30));
+		BOOST_CHECK(result == one_high / three_high);
+		// mixed precision as for the operators
+		add(result, one_rn, three_high);
+		BOOST_CHECK_EQUAL(result.get_precision(), static_cast<std::size_t>(30));
+		BOOST_CHECK(result == RealNumber("4.0", 30));
+		sub(result, three_high, one_rn);
+		BOOST_CHECK(result == RealNumber(two_str, 30));
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(expression_templates, RealNumberTestCases)
+	BOOST_AUTO_TEST_CASE(fused_multiply_add) {
+		RealNumber product = two_plus_small_rn * big_num_rn;
+		RealNumber fused = small_num_rn + two_plus_small_rn * big_num_rn;
+		BOOST_CHECK(fused == small_num_rn + product);
+		fused = big_num_rn - two_plus_small_rn * small_num_rn;
+		product = two_plus_small_rn * small_num_rn;
+		BOOST_CHECK(fused == big_num_rn - product);
+		// products on both sides and nested sums
+		fused = (one_rn + small_num_rn) * two_plus_small_rn - small_num_rn * small_num_rn;
+		RealNumber sum = one_rn + small_num_rn;
+		product = sum * two_plus_small_rn;
+		RealNumber square = small_num_rn.square();
+		BOOST_CHECK(fused == product - square);
+	}
+	BOOST_AUTO_TEST_CASE(single_limb_factor) {
+		RealNumber one_half("0.5");
+		RealNumber third = one_rn / RealNumber("3.0");
+		// exact for factors with 1 nonzero limb
+		BOOST_CHECK(third * two_rn == third + third);
+		BOOST_CHECK(two_rn * third == third + third);
+		BOOST_CHECK(third * one_half == third / two_rn);
+		BOOST_CHECK((third + two_plus_small_rn) * one_half == (third + two_plus_small_rn) / two_rn);
+		BOOST_CHECK(one_half * (third + third) == third);
+		BOOST_CHECK(third * zero_rn == zero_rn);
+		BOOST_CHECK(RealNumber("200000000.0") * RealNumber("4.0") == RealNumber("800000000.0"));
+	}
+	BOOST_AUTO_TEST_CASE(aliased_assignment) {
+		RealNumber x(two_plus_small_rn);
+		x = x * big_num_rn + x;
+		RealNumber expected = two_plus_small_rn * big_num_rn;
+		expected += two_plus_small_rn;
+		BOOST_CHECK(x == expected);
+		x = big_num_rn - x * small_num_rn * small_num_rn;
+		RealNumber product = expected * small_num_rn;
+		product = product * small_num_rn;
+		BOOST_CHECK(x == big_num_rn - product);
+		x = x - x;
+		BOOST_CHECK(x == zero_rn);
+	}
+	BOOST_AUTO_TEST_CASE(mixed_precision) {
+		RealNumber third_high = RealNumber(one_str, 30) / RealNumber("3.0", 30);
+		RealNumber x(one_rn);
+		x = x + third_high * two_rn;
+		BOOST_CHECK_EQUAL(x.get_precision(), static_cast<std::size_t>(30));
+		BOOST_CHECK(x == RealNumber(one_str, 30) + third_high + third_high);
+		BOOST_CHECK_EQUAL((one_rn * third_high + two_rn).get_precision(), static_cast<std::size_t>(30));
+	}
+	BOOST_AUTO_TEST_CASE(expression_members) {
+		// members of RealNumber called on expressions, which compile as they did
+		// before +, - and * returned expressions
+		const RealNumber sum = one_rn + two_rn;
+		const RealNumber product = two_rn * small_num_rn;
+		BOOST_CHECK_EQUAL((one_rn + two_rn).to_decimal_string(), sum.to_decimal_string());
+		BOOST_CHECK((two_rn * small_num_rn).equals(product));
+		BOOST_CHECK((two_rn - one_rn).difference(big_num_rn) == big_num_rn - one_rn);
+		BOOST_CHECK((one_rn + two_rn).square() == sum.square());
+		BOOST_CHECK_EQUAL((one_rn + two_rn).to_double(), 3.0);
+		BOOST_CHECK_EQUAL((one_rn * two_rn).get_decimal_precision(), one_rn.get_decimal_precision());
+		BOOST_CHECK(two_rn.equals(one_rn + one_rn));
+	}
+	BOOST_AUTO_TEST_CASE(temporary_operands) {
+		// a temporary operand is moved into the expression, so the stored
+		// expression is still valid after the statement
+		auto expression = small_num_rn + two_rn.square() * RealNumber("0.5");
+		RealNumber value = expression;
+		BOOST_CHECK(value == RealNumber("2.001"));
+		BOOST_CHECK(RealNumber(expression) == value);
+		BOOST_CHECK(RealNumber("1.5") - RealNumber("0.5") == one_rn);
+		BOOST_CHECK((two_rn + RealNumber("1.0")) * (RealNumber("2.0") - one_rn) == one_rn + two_rn);
+	}
+BOOST_AUTO_TEST_SUITE_END()
+
 BOOST_FIXTURE_TEST_SUITE(other_methods, RealNumberTestCases)
 	BOOST_AUTO_TEST_CASE(difference_method) {
 		BOOST_CHECK(big_num_rn.difference(two_rn) == big_num_rn - two_rn);
@@ -226,6 +371,62 @@ BOOST_FIXTURE_TEST_SUITE(other_methods, RealNumberTestCases)
 		BOOST_CHECK(!zero_rn.equals(small_num_rn));
 		BOOST_CHECK(!very_small_num_rn.equals(zero_rn));
 	}
+	BOOST_AUTO_TEST_CASE(double_conversion) {
+		BOOST_CHECK_EQUAL(two_rn.to_double(), 2.0);
+		BOOST_CHECK_EQUAL(zero_rn.to_double(), 0.0);
+		// 53 bits fit in the integer limb and 2 fractional limbs
+		BOOST_CHECK_EQUAL(RealNumber::from_double(0.1).to_double(), 0.1);
+		BOOST_CHECK_EQUAL(RealNumber::from_double(123456.789).to_double(), 123456.789);
+		BOOST_CHECK_EQUAL(RealNumber::from_double(1e-200, 30).to_double(), 1e-200);
+		BOOST_CHECK(RealNumber::from_double(0.25) == RealNumber("0.25"));
+		BOOST_CHECK(RealNumber::from_double(300000000.0) == RealNumber("300000000.0"));
+		BOOST_CHECK_EQUAL(RealNumber::from_double(0.5, 20).get_precision(), static_cast<std::size_t>(20));
+		BOOST_CHECK(std::abs(small_num_rn.to_double() - 0.001) < 1e-18);
+		// truncated, not rounded up to 1.0
+		BOOST_CHECK_EQUAL(RealNumber("0.99999999999999999999999999").to_double(), 1.0 - DBL_EPSILON / 2);
+		BOOST_CHECK_EQUAL(RealNumber("999999999.99999999999999999999").to_double(), std::nextafter(1e9, 0.0));
+		BOOST_CHECK_THROW(RealNumber::from_double(-1.0), std::invalid_argument);
+		BOOST_CHECK_THROW(RealNumber::from_double(4294967296.0), std::invalid_argument);
+	}
+	BOOST_AUTO_TEST_CASE(limb_conversion) {
+		const array_arithmetic::limb LIMBS[] = { 2, array_arithmetic::RADIX_MINUS_ONE, 7 };
+		RealNumber num = RealNumber::from_limbs(LIMBS, 2, 1);
+		BOOST_CHECK_EQUAL(num.get_precision(), static_cast<std::size_t>(1));
+		BOOST_CHECK(num == RealNumber("3.0", 1) - RealNumber::from_double(std::ldexp(1.0, -32), 1));
+		// truncated and extended
+		BOOST_CHECK(RealNumber::from_limbs(LIMBS, 3, 1) == num);
+		BOOST_CHECK(RealNumber::from_limbs(LIMBS, 1) == two_rn);
+		BOOST_CHECK_EQUAL(RealNumber::from_limbs(LIMBS, 3).get_precision(),
+				static_cast<std::size_t>(RealNumber::PRECISION));
+	}
+	BOOST_AUTO_TEST_CASE(equals_tolerance) {
+		const std::size_t HIGH = RealNumber::PRECISION + 2;
+		RealNumber one_half("0.5", HIGH), tolerance("15.0"), third(one_rn / RealNumber("3.0"));
+		// 1 unit of the last limb at the default precision, and a much smaller number
+		RealNumber ulp(one_rn), tiny(HIGH);
+		for (std::size_t i = 0; i < RealNumber::PRECISION * array_arithmetic::LIMB_BITS; ++i) { ulp *= one_half; }
+		tiny = ulp * one_half;
+		tolerance *= ulp;
+		BOOST_CHECK(third.equals(third + tolerance));
+		BOOST_CHECK(RealNumber(third + tolerance).equals(third));
+		BOOST_CHECK(!third.equals(third + tolerance + ulp));
+		BOOST_CHECK(!RealNumber(third + tolerance + ulp).equals(third));
+		// across a borrow from the integer limb
+		BOOST_CHECK(one_rn.equals(one_rn - tolerance));
+		BOOST_CHECK(!one_rn.equals(one_rn - tolerance - ulp));
+		// the tolerance is measured at the lower precision
+		RealNumber precise_third(third + tolerance + tiny);
+		BOOST_CHECK_EQUAL(precise_third.get_precision(), HIGH);
+		BOOST_CHECK(!third.equals(precise_third));
+		BOOST_CHECK(!precise_third.equals(third));
+		precise_third = third + tolerance - tiny;
+		BOOST_CHECK(third.equals(precise_third));
+		BOOST_CHECK(precise_third.equals(third));
+		precise_third = third - tolerance + tiny;
+		BOOST_CHECK(third.equals(precise_third));
+		precise_third = third - tolerance - tiny;
+		BOOST_CHECK(!third.equals(precise_third));
+	}
 	BOOST_AUTO_TEST_CASE(assign_value) {
 		RealNumber tmp;
 		tmp.assign_value(one_str);
@@ -236,3 +437,115 @@ BOOST_FIXTURE_TEST_SUITE(other_methods, RealNumberTestCases)
 		BOOST_CHECK(very_small_num_rn == tmp);
 	}
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(precision, RealNumberTestCases)
+	BOOST_AUTO_TEST_CASE(default_precision) {
+		BOOST_CHECK_EQUAL(one_rn.get_precision(), static_cast<std::size_t>(RealNumber::PRECISION));
+		BOOST_CHECK_EQUAL(one_rn.get_decimal_precision(), 
+				static_cast<std::size_t>(RealNumber::DECIMAL_PRECISION));
+	}
+	BOOST_AUTO_TEST_CASE(precision_for_digits) {
+		std::size_t limbs = RealNumber::precision_for_digits(1000);
+		RealNumber one_high(one_str, limbs);
+		BOOST_CHECK(one_high.get_decimal_precision() >= 1000);
+		BOOST_CHECK(one_high.get_decimal_precision() < 1010);
+		BOOST_CHECK_EQUAL(RealNumber::precision_for_digits(9), static_cast<std::size_t>(1));
+	}
+	BOOST_AUTO_TEST_CASE(high_precision_division) {
+		const std::size_t LIMBS = 40;
+		RealNumber third = RealNumber(one_str, LIMBS) / RealNumber("3.0", LIMBS);
+		std::string output = third.to_decimal_string();
+		BOOST_CHECK_EQUAL(output.size(), third.get_decimal_precision() + 2);
+		// all but the last digit are exact
+		BOOST_CHECK_EQUAL(output.substr(0, output.size() - 1), 
+				std::string("0.").append(output.size() - 3, '3'));
+	}
+	BOOST_AUTO_TEST_CASE(long_decimal_string) {
+		const std::size_t LIMBS = 200;
+		RealNumber seventh = RealNumber(one_str, LIMBS) / RealNumber("7.0", LIMBS);
+		std::string output = seventh.to_decimal_string();
+		BOOST_CHECK_EQUAL(output.size(), seventh.get_decimal_precision() + 2);
+		std::string expected("0.");
+		while (expected.size() < output.size()) { expected.append("142857"); }
+		// all but the last digit are exact
+		BOOST_CHECK_EQUAL(output.substr(0, output.size() - 1), expected.substr(0, output.size() - 1));
+	}
+	BOOST_AUTO_TEST_CASE(long_decimal_input) {
+		const std::size_t LIMBS = 200;
+		RealNumber seventh = RealNumber(one_str, LIMBS) / RealNumber("7.0", LIMBS);
+		std::string output = seventh.to_decimal_string();
+		RealNumber parsed(output, LIMBS);
+		BOOST_CHECK(parsed.equals(seventh));
+		BOOST_CHECK_EQUAL(parsed.to_decimal_string().substr(0, output.size() - 1),
+				output.substr(0, output.size() - 1));
+	}
+	BOOST_AUTO_TEST_CASE(newton_division) {
+		const std::size_t LIMBS = 40;
+		RealNumber dividend("2.718281828459045235360287471352662497757", LIMBS);
+		RealNumber divisor("0.000000314159265358979323846264338327950", LIMBS);
+		std::size_t original_threshold = array_arithmetic::newton_division_threshold;
+		array_arithmetic::newton_division_threshold = LIMBS + 2;
+		RealNumber expected = dividend / divisor;
+		array_arithmetic::newton_division_threshold = LIMBS + 1;
+		RealNumber actual = dividend / divisor;
+		BOOST_CHECK_THROW(dividend / RealNumber(LIMBS), std::invalid_argument);
+		array_arithmetic::newton_division_threshold = original_threshold;
+		BOOST_CHECK_EQUAL(actual.to_decimal_string(), expected.to_decimal_string());
+	}
+	BOOST_AUTO_TEST_CASE(mixed_precision_arithmetic) {
+		RealNumber one_high(one_str, 30);
+		RealNumber sum = one_high + one_rn;
+		BOOST_CHECK_EQUAL(sum.get_precision(), static_cast<std::size_t>(30));
+		BOOST_CHECK((one_rn + one_high).get_precision() == 30);
+		BOOST_CHECK(sum == two_rn);
+		BOOST_CHECK(two_rn - one_high == one_rn);
+		BOOST_CHECK((two_rn * one_high).get_precision() == 30);
+		BOOST_CHECK(two_rn * one_high == two_rn);
+		BOOST_CHECK((two_rn / one_high).get_precision() == 30);
+	}
+	BOOST_AUTO_TEST_CASE(mixed_precision_comparison) {
+		RealNumber two_high(two_str, 30);
+		RealNumber two_low(two_str, 2);
+		BOOST_CHECK(two_high == two_rn);
+		BOOST_CHECK(two_rn == two_high);
+		BOOST_CHECK(two_low == two_high);
+		BOOST_CHECK(!(two_high < two_low));
+		// a digit beyond the precision of two_low makes the number larger
+		RealNumber two_plus_tiny = two_high + RealNumber(very_small_num_str, 30);
+		BOOST_CHECK(two_plus_tiny > two_low);
+		BOOST_CHECK(two_low < two_plus_tiny);
+		BOOST_CHECK(two_low != two_plus_tiny);
+		// equals uses the tolerance of the less precise number
+		BOOST_CHECK(two_low.equals(two_plus_tiny));
+		BOOST_CHECK(two_plus_tiny.equals(two_low));
+		BOOST_CHECK(!two_high.equals(two_plus_tiny));
+	}
+	BOOST_AUTO_TEST_CASE(scratch_limbs) {
+		const std::size_t LIMBS = 100;
+		std::size_t scratch = RealNumber::scratch_limbs(LIMBS);
+		BOOST_CHECK(RealNumber::scratch_limbs(RealNumber::PRECISION) < scratch);
+		// operations at this precision stay within the reported peak
+		array_arithmetic::Workspace& ws = array_arithmetic::Workspace::local();
+		ws.reset_peak();
+		std::size_t in_use = ws.get_in_use();
+		RealNumber x = RealNumber(two_str, LIMBS) / RealNumber("3.0", LIMBS);
+		x = x * x;
+		x.to_decimal_string();
+		BOOST_CHECK(ws.get_peak() - in_use <= scratch);
+		BOOST_CHECK(ws.get_peak() - in_use > 0);
+	}
+	BOOST_AUTO_TEST_CASE(change_precision) {
+		RealNumber third = RealNumber(one_str, 30) / RealNumber("3.0", 30);
+		RealNumber third_low(third, 2);
+		BOOST_CHECK_EQUAL(third_low.get_precision(), static_cast<std::size_t>(2));
+		BOOST_CHECK(third_low < third);
+		third.set_precision(2);
+		BOOST_CHECK(third == third_low);
+		third.set_precision(30);
+		BOOST_CHECK(third == third_low);
+		// assignment copies the precision
+		RealNumber assigned;
+		assigned = third;
+		BOOST_CHECK_EQUAL(assigned.get_precision(), static_cast<std::size_t>(30));
+	}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,158 @@
+/**
+ * Test Suite for RealTaskGraph class
+ * command for running tests:
+ * ./real_task_graph_test --log_level=test_suite
+ *
+ * Copyright (c) 2012 Marshall Farrier
+ * license http://opensource.org/licenses/gpl-license.php GNU Public License
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "real_task_graph.h"
+#include "real_number.h"
+#include "array_arithmetic.h"
+
+// more threads than the processor may have, restored afterwards
+struct TaskGraphThreads {
+	std::size_t original_threads;
+	RealNumber a;
+	RealNumber b;
+	RealNumber one_half;
+
+	TaskGraphThreads() {
+		original_threads = array_arithmetic::get_thread_count();
+		array_arithmetic::set_thread_count(4);
+		a = RealNumber("1.5");
+		b = RealNumber("0.25");
+		one_half = RealNumber("0.5");
+	}
+	~TaskGraphThreads() { array_arithmetic::set_thread_count(original_threads); }
+};
+
+namespace {
+	// an operation long enough for another thread to take the next one, which
+	// records the thread it ran on
+	struct SleepingOperation {
+		std::mutex* mutex;
+		std::set<std::thread::id>* threads;
+		void operator()() const {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			std::lock_guard<std::mutex> lock(*mutex);
+			threads->insert(std::this_thread::get_id());
+		}
+	};
+}
+
+BOOST_FIXTURE_TEST_SUITE(task_graph, TaskGraphThreads)
+	BOOST_AUTO_TEST_CASE(dependencies) {
+		// a diamond 0 -> 1, 2 -> 3 and a node without dependencies
+		std::atomic<std::size_t> finished[5];
+		std::atomic<bool> in_order(true);
+		RealTaskGraph graph;
+		for (std::size_t i = 0; i < 5; ++i) { finished[i] = 0; }
+		const RealTaskGraph::Node TOP = graph.add([&]() { ++finished[0]; });
+		const RealTaskGraph::Node LEFT = graph.add([&]() {
+			if (finished[0] != finished[1] + 1) { in_order = false; }
+			++finished[1];
+		}, {TOP});
+		const RealTaskGraph::Node RIGHT = graph.add([&]() {
+			if (finished[0] != finished[2] + 1) { in_order = false; }
+			++finished[2];
+		}, {TOP});
+		graph.add([&]() {
+			if (finished[1] != finished[3] + 1 || finished[2] != finished[3] + 1) { in_order = false; }
+			++finished[3];
+		}, {LEFT, RIGHT});
+		graph.add([&]() { ++finished[4]; });
+		BOOST_CHECK_EQUAL(graph.size(), static_cast<std::size_t>(5));
+		for (std::size_t run = 0; run < 20; ++run) { graph.run(run % 2 == 0); }
+		for (std::size_t i = 0; i < 5; ++i) { BOOST_CHECK_EQUAL(finished[i], static_cast<std::size_t>(20)); }
+		BOOST_CHECK(in_order);
+		BOOST_CHECK_THROW(graph.add([]() {}, {5}), std::invalid_argument);
+	}
+	BOOST_AUTO_TEST_CASE(successors_run_concurrently) {
+		// successors are queued by the thread that ran the root, and the thread
+		// waiting in run() must take some of them, on every run
+		array_arithmetic::set_thread_count(2);
+		std::mutex mutex;
+		std::set<std::thread::id> root_threads, successor_threads;
+		SleepingOperation root = {&mutex, &root_threads};
+		SleepingOperation successor = {&mutex, &successor_threads};
+		RealTaskGraph graph;
+		const RealTaskGraph::Node ROOT = graph.add(root);
+		for (std::size_t i = 0; i < 3; ++i) { graph.add(successor, {ROOT}); }
+		graph.run();
+		for (std::size_t run = 0; run < 4; ++run) {
+			successor_threads.clear();
+			graph.run();
+			BOOST_CHECK_EQUAL(successor_threads.size(), static_cast<std::size_t>(2));
+		}
+	}
+	BOOST_AUTO_TEST_CASE(independent_nodes_run_concurrently) {
+		// 2 independent nodes and 1 that needs both, as for a + b, a * b and sqrt(a * b)
+		array_arithmetic::set_thread_count(2);
+		std::mutex mutex;
+		std::set<std::thread::id> independent_threads, join_threads;
+		SleepingOperation independent = {&mutex, &independent_threads};
+		SleepingOperation join = {&mutex, &join_threads};
+		RealTaskGraph graph;
+		const RealTaskGraph::Node LEFT = graph.add(independent);
+		const RealTaskGraph::Node RIGHT = graph.add(independent);
+		graph.add(join, {LEFT, RIGHT});
+		graph.run();
+		for (std::size_t run = 0; run < 4; ++run) {
+			independent_threads.clear();
+			const std::chrono::steady_clock::time_point START = std::chrono::steady_clock::now();
+			graph.run();
+			const double MILLISECONDS = std::chrono::duration<double, std::milli>(
+					std::chrono::steady_clock::now() - START).count();
+			BOOST_CHECK_EQUAL(independent_threads.size(), static_cast<std::size_t>(2));
+			// 2 operations in a row rather than 3, with some slack
+			BOOST_CHECK(MILLISECONDS < 55.0);
+		}
+	}
+	BOOST_AUTO_TEST_CASE(assignments) {
+		RealNumber mean, product, difference;
+		RealTaskGraph graph;
+		const RealTaskGraph::Node MEAN = graph.assign(mean, (a + b) * one_half);
+		graph.assign(product, a * b);
+		graph.assign(difference, a - mean, {MEAN});
+		graph.run();
+		BOOST_CHECK(mean == RealNumber("0.875"));
+		BOOST_CHECK(product == RealNumber("0.375"));
+		BOOST_CHECK(difference == RealNumber("0.625"));
+		// operands are referenced, so the next run uses their new values
+		a = RealNumber("2.5");
+		graph.run();
+		BOOST_CHECK(mean == RealNumber("1.375"));
+		BOOST_CHECK(product == RealNumber("0.625"));
+		BOOST_CHECK(difference == RealNumber("1.125"));
+		// the same results serially
+		a = RealNumber("1.5");
+		graph.run(false);
+		BOOST_CHECK(mean == RealNumber("0.875"));
+		BOOST_CHECK(difference == RealNumber("0.625"));
+	}
+	BOOST_AUTO_TEST_CASE(exceptions) {
+		RealNumber quotient;
+		const RealNumber zero;
+		bool dependent_ran = false;
+		RealTaskGraph graph;
+		const RealTaskGraph::Node DIVISION = graph.add([&]() { quotient = a / zero; });
+		graph.add([&]() { dependent_ran = true; }, {DIVISION});
+		BOOST_CHECK_THROW(graph.run(), std::invalid_argument);
+		BOOST_CHECK(!dependent_ran);
+		BOOST_CHECK_THROW(graph.run(false), std::invalid_argument);
+		BOOST_CHECK(!dependent_ran);
+	}
+BOOST_AUTO_TEST_SUITE_END()